@@ -0,0 +1,1049 @@
+/*
+** US-2400 bench harness
+** Headless MIDI replay benchmark for CSurf_US2400
+**
+** Loads the surface through ReaperPluginEntry() with a mock REAPER API,
+** feeds synthetic or recorded US-2400 MIDI through the surface's own input
+** device and reports Run() cycle times, per-event handler latency, host API
+** calls and MIDI output traffic.
+**
+** Replay files: one event per line, "<cycle> <status> <d1> <d2> [<d3>]"
+** (cycle decimal, bytes hex), '#' starts a comment.
+*/
+
+#include "reaper_mock.h"
+#include "../csurf_us2400_protocol.h"
+#include "../csurf_us2400_taper.h"
+#include "../csurf_us2400_outqueue.h"
+#include <algorithm>
+#include <time.h>
+#include <math.h>
+
+extern "C" int ReaperPluginEntry(HINSTANCE hInstance, reaper_plugin_info_t* rec);
+
+
+////// OPTIONS //////
+
+struct BenchOpts
+{
+  MockProjectCfg proj;
+  int cycles;
+  int isolated;      // events timed one per Run() for latency
+  int top;           // api calls listed per scenario
+  bool strip;        // scribble strip window open
+  bool mkey;         // m-key mode instead of meter mode
+  double jitter;     // Run() period 1/30 s -/+ this many ms, alternating
+  const char* replay;
+};
+
+static BenchOpts g_opts;
+
+
+////// TIMING //////
+
+static double Bench_Now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3; // us
+}
+
+static double Bench_Pct(std::vector<double>& v, double pct)
+{
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(pct / 100.0 * (double)(v.size() - 1) + 0.5);
+  return v[i];
+}
+
+
+////// SURFACE //////
+
+static IReaperControlSurface* Bench_CreateSurface()
+{
+  Mock_Init(&g_opts.proj);
+
+  // Stp_RetrieveCoords() picks this up on init
+  if (g_opts.strip) Mock_SetExtState("US2400", "stp_open", "1");
+
+  reaper_plugin_info_t rec;
+  rec.caller_version = REAPER_PLUGIN_VERSION;
+  rec.hwnd_main = NULL;
+  rec.Register = Mock_Register;
+  rec.GetFunc = Mock_GetFunc;
+
+  if (!ReaperPluginEntry(NULL, &rec) || !Mock_CsurfReg())
+  {
+    fprintf(stderr, "bench: plugin entry failed\n");
+    exit(1);
+  }
+
+  int err = 0;
+  IReaperControlSurface* surf = Mock_CsurfReg()->create("US-2400", g_opts.mkey ? "1 0 0 0" : "0 0 0 0", &err);
+  if (!surf || err)
+  {
+    fprintf(stderr, "bench: surface creation failed (%d)\n", err);
+    exit(1);
+  }
+
+  Mock_SetSurface(surf);
+
+  // first Run() does the init, let blink and meters settle
+  for (int i = 0; i < 40; i++)
+  {
+    Mock_Tick(1.0 / 30.0);
+    surf->Run();
+  }
+
+  return surf;
+}
+
+
+static void Bench_DestroySurface(IReaperControlSurface* surf)
+{
+  Mock_SetSurface(NULL);
+  delete surf;
+  Mock_Free();
+}
+
+
+////// SCENARIOS //////
+
+// a scenario queues the MIDI (or host changes) for one Run() cycle
+typedef void (*ScenarioFunc)(IReaperControlSurface* surf, int cycle);
+
+// optional: checks the project after a cycle, returns mismatches
+typedef int (*ScenarioCheck)();
+
+struct Scenario
+{
+  const char* name;
+  const char* desc;
+  ScenarioFunc setup; // once, before measuring (may be NULL)
+  ScenarioFunc cycle;
+  ScenarioCheck check; // may be NULL
+};
+
+
+static void Btn(unsigned char id, bool on)
+{
+  Mock_QueueMIDI(0xb1, id, on ? 0x7f : 0x00, 0);
+}
+
+static void Press(unsigned char id)
+{
+  Btn(id, true);
+  Btn(id, false);
+}
+
+static void Fader(unsigned char ch, int value)
+{
+  // lsb on 0x20 + ch (the surface reads it from the 4th byte), msb on ch
+  unsigned char lsb = value & 0x7f;
+  Mock_QueueMIDI(0xb0, 0x20 + ch, lsb, lsb);
+  Mock_QueueMIDI(0xb0, ch, (value >> 7) & 0x7f, 0);
+}
+
+static void Encoder(unsigned char ch, int rel)
+{
+  Mock_QueueMIDI(0xb0, 0x40 + ch, rel >= 0 ? rel : 0x40 - rel, 0);
+}
+
+
+static void Scn_Idle(IReaperControlSurface* surf, int cycle)
+{
+}
+
+
+// last value sent per fader, for Chk_Faders
+static int g_fdr_sent[8];
+
+static void Scn_FaderSetup(IReaperControlSurface* surf, int cycle)
+{
+  for (int ch = 0; ch < 8; ch++) Btn(ch * 4, true); // touch
+}
+
+static void Scn_Faders(IReaperControlSurface* surf, int cycle)
+{
+  // 8 faders ridden at once, ~3 updates per fader per cycle
+  for (int step = 0; step < 3; step++)
+  {
+    for (int ch = 0; ch < 8; ch++)
+    {
+      int v = 8192 + (int)(6000.0 * sin((cycle * 3 + step) * 0.05 + ch * 0.7));
+      Fader(ch, v);
+      g_fdr_sent[ch] = v;
+    }
+  }
+}
+
+
+static void Scn_FadersInterleaved(IReaperControlSurface* surf, int cycle)
+{
+  // dense burst: lsbs of several faders arrive before their msbs
+  for (int step = 0; step < 3; step++)
+  {
+    int v[8];
+    for (int ch = 0; ch < 8; ch++)
+    {
+      v[ch] = 8192 + (int)(6000.0 * sin((cycle * 3 + step) * 0.05 + ch * 0.7));
+      unsigned char lsb = v[ch] & 0x7f;
+      Mock_QueueMIDI(0xb0, 0x20 + ch, lsb, lsb);
+      g_fdr_sent[ch] = v[ch];
+    }
+    for (int ch = 0; ch < 8; ch++) Mock_QueueMIDI(0xb0, ch, (v[ch] >> 7) & 0x7f, 0);
+  }
+}
+
+
+static int Chk_Faders()
+{
+  // track volume must match the last 14 bit value of its fader (bank 1)
+  int bad = 0;
+  for (int ch = 0; ch < 8; ch++)
+  {
+    MockTrack* tk = Mock_Track(ch + 1);
+    if (!tk) continue;
+    double got = Mock_VolToSlider(tk->vol) * 16256.0 / 1000.0 - 41.0;
+    if (fabs(got - (double)g_fdr_sent[ch]) > 2.0) bad++;
+  }
+  return bad;
+}
+
+
+static void Scn_Encoders(IReaperControlSurface* surf, int cycle)
+{
+  // 24 encoders spun, fast turns give several ticks per cycle
+  for (int step = 0; step < 4; step++)
+    for (int ch = 0; ch < 24; ch++)
+      Encoder(ch, ((cycle / 30) % 2) ? 1 + (ch % 3) : -1 - (ch % 3));
+}
+
+
+static void Scn_Jog(IReaperControlSurface* surf, int cycle)
+{
+  for (int step = 0; step < 8; step++)
+    Mock_QueueMIDI(0xb0, 0x3c, ((cycle / 45) % 2) ? 0x01 : 0x41, 0);
+}
+
+
+static void Scn_Buttons(IReaperControlSurface* surf, int cycle)
+{
+  int ch = cycle % 24;
+  Press(ch * 4 + 1); // select
+  Press(ch * 4 + 2); // solo
+  Press(ch * 4 + 3); // mute
+}
+
+
+static void Scn_Banks(IReaperControlSurface* surf, int cycle)
+{
+  Press(((cycle / 4) % 2) ? 0x70 : 0x71);
+}
+
+
+static void Scn_AuxSetup(IReaperControlSurface* surf, int cycle)
+{
+  Press(0x65); // aux 1
+}
+
+static void Scn_Aux(IReaperControlSurface* surf, int cycle)
+{
+  if (cycle % 15 == 0) Press(0x65 + (cycle / 15) % 6); // switch aux 1-6
+  for (int ch = 0; ch < 24; ch++) Encoder(ch, (cycle % 2) ? 1 : -1);
+}
+
+
+static void Scn_SendAutomation(IReaperControlSurface* surf, int cycle)
+{
+  // send automation playback: REAPER reports every track's first send
+  for (int t = 1; t <= 24; t++) Mock_HostSetSendVolume(t, 0, 0.5 + 0.4 * sin(cycle * 0.1 + t));
+}
+
+
+static void Scn_ChanSetup(IReaperControlSurface* surf, int cycle)
+{
+  Press(0x64); // chan
+}
+
+static void Scn_Chan(IReaperControlSurface* surf, int cycle)
+{
+  for (int ch = 0; ch < 24; ch++) Encoder(ch, (cycle % 2) ? 2 : -2);
+}
+
+
+static void Scn_FXAutomation(IReaperControlSurface* surf, int cycle)
+{
+  // fx automation playback: REAPER reports the params of the fx chan mode shows
+  MockTrack* tk = Mock_Track(1);
+  if (!tk || tk->fx.empty()) return;
+  int fx = (int)tk->fx.size() - 1;
+  for (int p = 0; p < 24; p++) Mock_HostSetFXParam(1, fx, p, 0.5 + 0.4 * sin(cycle * 0.1 + p));
+}
+
+
+static void Scn_Automation(IReaperControlSurface* surf, int cycle)
+{
+  // automation playback: REAPER pushes vol/pan of every track and polls touch
+  int n = Mock_NumTracks();
+  for (int t = 0; t <= n; t++)
+  {
+    Mock_HostSetVolume(t, 0.5 + 0.4 * sin(cycle * 0.1 + t));
+    Mock_HostSetPan(t, 0.8 * sin(cycle * 0.07 + t));
+    Mock_HostPollTouch(t);
+  }
+}
+
+
+static void Scn_SelectAll(IReaperControlSurface* surf, int cycle)
+{
+  // select all / unselect all and clear solo storms
+  int n = Mock_NumTracks();
+  bool sel = (cycle % 2) == 0;
+  for (int t = 1; t <= n; t++) Mock_HostSetSelected(t, sel);
+  for (int t = 1; t <= n; t++) Mock_HostSetSolo(t, sel ? 2 : 0);
+}
+
+
+struct ReplayEvt
+{
+  int cycle;
+  unsigned char msg[4];
+};
+
+static std::vector<ReplayEvt> g_replay;
+
+static bool Bench_LoadReplay(const char* fn)
+{
+  FILE* fp = fopen(fn, "r");
+  if (!fp) return false;
+
+  char line[256];
+  while (fgets(line, sizeof(line), fp))
+  {
+    char* c = strchr(line, '#');
+    if (c) *c = 0;
+
+    ReplayEvt e;
+    unsigned int b[4] = { 0, 0, 0, 0 };
+    int n = sscanf(line, "%d %x %x %x %x", &e.cycle, &b[0], &b[1], &b[2], &b[3]);
+    if (n < 4) continue;
+    if (n == 4) b[3] = b[2]; // plain 3 byte message: mirror the data byte
+    for (int i = 0; i < 4; i++) e.msg[i] = (unsigned char)b[i];
+    g_replay.push_back(e);
+  }
+
+  fclose(fp);
+  return true;
+}
+
+static void Scn_Replay(IReaperControlSurface* surf, int cycle)
+{
+  if (g_replay.empty()) return;
+  int len = g_replay.back().cycle + 1;
+  int c = cycle % len;
+  for (size_t i = 0; i < g_replay.size(); i++)
+    if (g_replay[i].cycle == c)
+      Mock_QueueMIDI(g_replay[i].msg[0], g_replay[i].msg[1], g_replay[i].msg[2], g_replay[i].msg[3]);
+}
+
+
+static Scenario g_scenarios[] =
+{
+  { "idle", "no input: meters, blink, feedback only", NULL, Scn_Idle, NULL },
+  { "faders", "8 touched faders ridden, 3 moves each per cycle", Scn_FaderSetup, Scn_Faders, Chk_Faders },
+  { "faders-il", "as faders, lsb/msb of different faders interleaved", Scn_FaderSetup, Scn_FadersInterleaved, Chk_Faders },
+  { "encoders", "24 encoders, 4 ticks each per cycle (pan)", NULL, Scn_Encoders, NULL },
+  { "jog", "jog wheel, 8 ticks per cycle", NULL, Scn_Jog, NULL },
+  { "buttons", "select/solo/mute presses", NULL, Scn_Buttons, NULL },
+  { "banks", "bank left/right every cycle", NULL, Scn_Banks, NULL },
+  { "aux", "aux modes 1-6, encoders on send levels", Scn_AuxSetup, Scn_Aux, NULL },
+  { "sendauto", "aux mode 1, host automates the first send of every track", Scn_AuxSetup, Scn_SendAutomation, NULL },
+  { "chan", "channel strip, encoders on fx params", Scn_ChanSetup, Scn_Chan, NULL },
+  { "fxauto", "channel strip, host automates the shown fx params", Scn_ChanSetup, Scn_FXAutomation, NULL },
+  { "automation", "host pushes vol/pan of all tracks, polls touch", NULL, Scn_Automation, NULL },
+  { "selectall", "host selects/unselects and solos all tracks", NULL, Scn_SelectAll, NULL },
+  { "replay", "events from -r file", NULL, Scn_Replay, NULL },
+  { NULL, NULL, NULL, NULL, NULL }
+};
+
+
+////// MEASUREMENT //////
+
+static void Bench_Scenario(const Scenario* scn)
+{
+  IReaperControlSurface* surf = Bench_CreateSurface();
+
+  if (scn->setup)
+  {
+    scn->setup(surf, 0);
+    Mock_Tick(1.0 / 30.0);
+    surf->Run();
+  }
+
+  Mock_ResetCounters();
+
+  // throughput: a whole cycle's input per Run(), as REAPER delivers it
+  std::vector<double> run_us;
+  long events = 0;
+  long mismatches = 0;
+
+  for (int c = 0; c < g_opts.cycles; c++)
+  {
+    Mock_Tick(1.0 / 30.0 + ((c & 1) ? g_opts.jitter : -g_opts.jitter) / 1000.0);
+    double t0 = Bench_Now();
+    scn->cycle(surf, c); // host side changes are part of the cycle
+    events += Mock_QueuedMIDI();
+    surf->Run();
+    run_us.push_back(Bench_Now() - t0);
+
+    if (scn->check) mismatches += scn->check();
+  }
+
+  long api = Mock_TotalCalls();
+  long out_msgs = Mock_MIDIOutMsgs();
+  long out_bytes = Mock_MIDIOutBytes();
+  long out_flushes = Mock_MIDIOutFlushes();
+  long out_badbytes = Mock_MIDIOutBadBytes();
+  std::vector<MockApiCount> counts;
+  Mock_GetCounts(&counts);
+  std::vector<std::string> names;
+  for (int i = 0; i < g_opts.top && i < (int)counts.size(); i++) names.push_back(counts[i].name);
+
+  // latency: one event per Run(), minus the median of idle Run()s in between
+  std::vector<double> ev_us, idle_us;
+  std::vector<MIDI_event_t> evts;
+  for (int c = 0; (int)ev_us.size() < g_opts.isolated && c < g_opts.cycles; c++)
+  {
+    scn->cycle(surf, c);
+    Mock_TakeQueuedMIDI(&evts);
+
+    for (size_t e = 0; e < evts.size() && (int)ev_us.size() < g_opts.isolated; e++)
+    {
+      double t0 = Bench_Now();
+      surf->Run();
+      idle_us.push_back(Bench_Now() - t0);
+
+      Mock_QueueEvent(&evts[e]);
+      t0 = Bench_Now();
+      surf->Run();
+      ev_us.push_back(Bench_Now() - t0);
+    }
+  }
+
+  double idle = Bench_Pct(idle_us, 50.0);
+  for (size_t i = 0; i < ev_us.size(); i++) ev_us[i] = ev_us[i] > idle ? ev_us[i] - idle : 0.0;
+
+  double cyc = (double)g_opts.cycles;
+  printf("%-11s %7.1f %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f %9.1f %8.1f %8.1f %6.2f\n",
+    scn->name, (double)events / cyc,
+    Bench_Pct(run_us, 50.0), Bench_Pct(run_us, 90.0), Bench_Pct(run_us, 99.0), Bench_Pct(run_us, 100.0),
+    Bench_Pct(ev_us, 50.0), Bench_Pct(ev_us, 99.0),
+    (double)api / cyc, (double)out_msgs / cyc, (double)out_bytes / cyc, (double)out_flushes / cyc);
+
+  if (scn->check) printf("    check: %ld mismatches in %d cycles\n", mismatches, g_opts.cycles);
+  if (out_badbytes > 0) printf("    midi out: %ld data bytes with the status bit set\n", out_badbytes);
+
+  for (size_t i = 0; i < names.size(); i++)
+    printf("    %-34s %10.1f/cycle\n", names[i].c_str(), (double)counts[i].calls / cyc);
+
+  Bench_DestroySurface(surf);
+} // Bench_Scenario
+
+
+////// PROTOCOL //////
+
+// the decode cascade MIDIin used before the table, as reference
+static __attribute__((noinline)) Prt_Decoded Bench_RefDecode(unsigned char status, unsigned char cc)
+{
+  static const unsigned char master[] =
+  {
+    PRT_MASTERSEL, PRT_CLRSOLO, PRT_FLIP, PRT_CHAN, PRT_AUX, PRT_AUX, PRT_AUX, PRT_AUX, PRT_AUX, PRT_AUX,
+    PRT_METER, PRT_PAN, PRT_FKEY, PRT_NULL, PRT_SCRUB, PRT_BANKDOWN, PRT_BANKUP, PRT_IN, PRT_OUT, PRT_SHIFT,
+    PRT_REW, PRT_FWD, PRT_STOP, PRT_PLAY, PRT_REC
+  };
+  static const unsigned char elements[] = { PRT_TOUCH, PRT_SEL, PRT_SOLO, PRT_MUTE };
+
+  Prt_Decoded d = { PRT_NONE, 0 };
+  cc &= 0x7f;
+
+  if (status == 0xb1)
+  {
+    if ( (cc >= 0x61) && (cc <= 0x79) )
+    {
+      d.handler = master[cc - 0x61];
+      if (cc == 0x61) d.ch = 24;
+      else if (d.handler == PRT_AUX) d.ch = cc - 0x64;
+    } else if (cc < 0x60)
+    {
+      d.handler = elements[cc % 4];
+      d.ch = cc / 4;
+    }
+  } else if (status == 0xb0)
+  {
+    if (cc < 0x19) { d.handler = PRT_FDRMSB; d.ch = cc; }
+    else if ( (cc >= 0x20) && (cc <= 0x38) ) { d.handler = PRT_FDRLSB; d.ch = cc - 0x20; }
+    else if (cc == 0x3c) d.handler = PRT_JOG;
+    else if ( (cc >= 0x40) && (cc <= 0x57) ) { d.handler = PRT_ENC; d.ch = cc - 0x40; }
+  } else if (status == 0xb2)
+  {
+    d.handler = PRT_MASTERTOUCH;
+    d.ch = 24;
+  } else if (status == 0xbe) d.handler = PRT_JOYSTICK;
+
+  return d;
+}
+
+
+static void Bench_Protocol()
+{
+  // decode table against the reference, every status / cc
+  int bad = 0, mapped = 0;
+  for (int status = 0x80; status <= 0xff; status++)
+  {
+    for (int cc = 0; cc < 128; cc++)
+    {
+      Prt_Decoded ref = Bench_RefDecode(status, cc);
+      const Prt_Decoded& tab = Prt_Decode(status, cc);
+      if (ref.handler != PRT_NONE) mapped++;
+      if ( (ref.handler != tab.handler) || ((ref.handler != PRT_NONE) && (ref.ch != tab.ch)) )
+      {
+        if (bad++ < 10) printf("  mismatch: %02x %02x -> %d/%d, expected %d/%d\n", status, cc, tab.handler, tab.ch, ref.handler, ref.ch);
+      }
+    }
+  }
+  printf("decode table: %d controls, %d mapped messages, %d mismatches\n", PRT_CONTROLS, mapped, bad);
+
+  // encoding: output ccs the surface used before the control map
+  int out_bad = 0;
+  for (int ch = 0; ch < 25; ch++)
+  {
+    if (Prt_Out<PRT_FDRMSB>::CC(ch) != ch) out_bad++;
+    if (Prt_Out<PRT_FDRLSB>::CC(ch) != ch + 0x1f) out_bad++;
+    if (ch < 24 && Prt_Out<PRT_ENC>::CC(ch) != ch + 0x40) out_bad++;
+    if (ch < 24 && Prt_Out<PRT_RING>::CC(ch) != ch + 0x60) out_bad++;
+    if (Prt_Out<PRT_SEL>::CC(ch) != ch * 4 + 1 || Prt_Out<PRT_SOLO>::CC(ch) != ch * 4 + 2 || Prt_Out<PRT_MUTE>::CC(ch) != ch * 4 + 3) out_bad++;
+  }
+  if (Prt_Out<PRT_BANKLED>::CC(0) != 0x5d) out_bad++;
+  printf("encoding: %d mismatches\n", out_bad);
+
+  // throughput on a realistic mix: faders, encoders, track elements, master keys
+  const int n = 4096;
+  std::vector<unsigned char> st(n), cc(n);
+  unsigned int seed = 2400;
+  for (int i = 0; i < n; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    int kind = (seed >> 16) % 4;
+    int r = (seed >> 8) & 0x7f;
+    if (kind == 0) { st[i] = 0xb0; cc[i] = (r % 2) ? (r % 25) : 0x20 + (r % 25); }
+    else if (kind == 1) { st[i] = 0xb0; cc[i] = 0x40 + (r % 24); }
+    else if (kind == 2) { st[i] = 0xb1; cc[i] = r % 0x60; }
+    else { st[i] = 0xb1; cc[i] = 0x61 + (r % 25); }
+  }
+
+  const int rounds = 2000;
+  unsigned int sum = 0;
+
+  double t0 = Bench_Now();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < n; i++) { Prt_Decoded d = Bench_RefDecode(st[i], cc[i]); sum += d.handler + d.ch; }
+  double t_ref = Bench_Now() - t0;
+
+  t0 = Bench_Now();
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < n; i++) { const Prt_Decoded& d = Prt_Decode(st[i], cc[i]); sum += d.handler + d.ch; }
+  double t_tab = Bench_Now() - t0;
+
+  double msgs = (double)n * (double)rounds;
+  printf("decode: cascade %.2f ns/msg, table %.2f ns/msg (%u)\n", t_ref * 1000.0 / msgs, t_tab * 1000.0 / msgs, sum & 1);
+} // Bench_Protocol
+
+
+////// TAPER //////
+
+// the conversions as they were before the taper tables, host calls and logs
+static double (*b_slider2db)(double);
+static double (*b_db2slider)(double);
+
+static double Ref_FaderToVol(int value)
+{
+  double v = ((double)(value + 41) * 1000.0) / 16256.0;
+  if (v < 0.0) v = 0.0;
+  else if (v > 1000.0) v = 1000.0;
+  return DB2VAL(b_slider2db(v));
+}
+
+static int Ref_VolToFader(double value)
+{
+  double v = b_db2slider(VAL2DB(value)) * 16256.0 / 1000.0 + 41;
+  if (v < 50.0) v = 0.0;
+  else if (v > 16250.0) v = 16383.0;
+  return (int)(v + 0.5);
+}
+
+static int Ref_VolToEncoder(double value)
+{
+  double v = (b_db2slider(VAL2DB(value)) * 14.0 / 1000.0) + 1;
+  if (v < 1.0) v = 1.0;
+  else if (v > 15.0) v = 15.0;
+  return (int)(v + 0.5);
+}
+
+static int Ref_PeakToEncoder(double value)
+{
+  double v = VAL2DB(value);
+  if (v > -90.0) v = ((-90.0 - v) / -90.0 * 15.0) + 0.5;
+  else v = 0.0;
+  if (v > 15.0) v = 15.0;
+  return (int)v;
+}
+
+// exact meter level in 1/16 steps (0 - TPR_LEVELS), by table
+static double ref_level[TPR_LEVELS + 1]; // gain at which level n is reached
+
+static void Ref_InitLevels(double minusinf)
+{
+  for (int level = 0; level <= TPR_LEVELS; level++)
+    ref_level[level] = DB2VAL(minusinf - minusinf * (double)level / (double)TPR_LEVELS);
+}
+
+static int Ref_PeakToLevel(double peak)
+{
+  if (peak < ref_level[0]) return 0;
+  if (peak >= ref_level[TPR_LEVELS]) return TPR_LEVELS;
+
+  // last level with ref_level[lo] <= peak
+  int lo = 0, hi = TPR_LEVELS;
+  while (hi - lo > 1)
+  {
+    int mid = (lo + hi) >> 1;
+    if (ref_level[mid] <= peak) lo = mid;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// same wrappers as the Cnv_ functions, on the tables
+static double Tab_FaderToVol(int value) { return Tpr_PosToGain((double)(value + 41) * (double)TPR_MAX / 16256.0); }
+
+static int Tab_VolToFader(double value)
+{
+  double v = Tpr_GainToPos(value) * 16256.0 / (double)TPR_MAX + 41;
+  if (v < 50.0) v = 0.0;
+  else if (v > 16250.0) v = 16383.0;
+  return (int)(v + 0.5);
+}
+
+static int Tab_VolToEncoder(double value)
+{
+  double v = (Tpr_GainToPos(value) * 14.0 / (double)TPR_MAX) + 1;
+  if (v < 1.0) v = 1.0;
+  else if (v > 15.0) v = 15.0;
+  return (int)(v + 0.5);
+}
+
+
+static void Bench_Taper()
+{
+  b_slider2db = (double (*)(double))Mock_GetFunc("SLIDER2DB");
+  b_db2slider = (double (*)(double))Mock_GetFunc("DB2SLIDER");
+
+  double t0 = Bench_Now();
+  Tpr_Init(b_slider2db, -90.0);
+  Ref_InitLevels(-90.0);
+  printf("taper tables: %d entries, built in %.0f us\n", TPR_SIZE, Bench_Now() - t0);
+
+  // fader -> gain, every fader value
+  double fwd_db = 0.0;
+  for (int v = 0; v < 16384; v++)
+  {
+    double ref = Ref_FaderToVol(v);
+    if (VAL2DB(ref) < -120.0) continue;
+    double err = fabs(VAL2DB(Tab_FaderToVol(v)) - VAL2DB(ref));
+    if (err > fwd_db) fwd_db = err;
+  }
+
+  // gain -> position / fader / encoder, -150 dB .. +12 dB in 0.001 dB
+  double inv_pos = 0.0;
+  int fdr_off = 0, fdr_max = 0, enc_off = 0, steps = 0;
+  for (double db = -150.0; db <= 12.0; db += 0.001)
+  {
+    double g = DB2VAL(db);
+    double ref = b_db2slider(db) * (double)TPR_MAX / 1000.0;
+    double err = fabs(Tpr_GainToPos(g) - ref);
+    if (db > -120.0 && err > inv_pos) inv_pos = err;
+
+    int d = abs(Tab_VolToFader(g) - Ref_VolToFader(g));
+    if (d) fdr_off++;
+    if (d > fdr_max) fdr_max = d;
+    if (Tab_VolToEncoder(g) != Ref_VolToEncoder(g)) enc_off++;
+    steps++;
+  }
+
+  // ballistics levels round to the same meter steps, apart from ties
+  int level_off = 0, peaks = 0;
+  for (double db = -100.0; db <= 6.0; db += 0.0007)
+  {
+    double g = DB2VAL(db);
+    if (((Ref_PeakToLevel(g) + 8) >> 4) != Ref_PeakToEncoder(g)) level_off++;
+    peaks++;
+  }
+
+  printf("fader -> gain: max error %.6f dB (above -120 dB)\n", fwd_db);
+  printf("gain -> position: max error %.5f of %d (above -120 dB)\n", inv_pos, TPR_MAX);
+  printf("gain -> fader: %d of %d differ, by at most %d\n", fdr_off, steps, fdr_max);
+  printf("gain -> encoder: %d of %d differ\n", enc_off, steps);
+  printf("peak -> level -> meter: %d of %d differ\n", level_off, peaks);
+
+  bool ok = (fwd_db < 0.00001) && (inv_pos < 0.001) && (fdr_max <= 1);
+  printf("error bound (0.00001 dB / 0.001 position / 1 fader step): %s\n", ok ? "ok" : "EXCEEDED");
+
+  // speed
+  const int n = 1000000;
+  double sum = 0.0;
+  t0 = Bench_Now();
+  for (int i = 0; i < n; i++) sum += Ref_VolToFader(Ref_FaderToVol(i & 16383));
+  double t_ref = Bench_Now() - t0;
+  t0 = Bench_Now();
+  for (int i = 0; i < n; i++) sum += Tab_VolToFader(Tab_FaderToVol(i & 16383));
+  double t_tab = Bench_Now() - t0;
+  printf("fader -> gain -> fader: direct %.1f ns, tables %.1f ns (%d)\n", t_ref * 1000.0 / n, t_tab * 1000.0 / n, (int)sum & 1);
+
+#if defined(TPR_AVX2)
+  const char* path = "avx2";
+#elif defined(TPR_SSE2)
+  const char* path = "sse2";
+#else
+  const char* path = "scalar";
+#endif
+
+  // log2 polynomial on the mantissa
+  double log2_err = 0.0;
+  for (int i = 0; i < 1000000; i++)
+  {
+    double t = (double)i / 1000000.0;
+    double p = ((((TPR_LOG2_C5 * t + TPR_LOG2_C4) * t + TPR_LOG2_C3) * t + TPR_LOG2_C2) * t + TPR_LOG2_C1) * t;
+    double err = fabs(p - log2(1.0 + t));
+    if (err > log2_err) log2_err = err;
+  }
+  printf("fast log2: max error %.2e (%.5f dB)\n", log2_err, log2_err * 20.0 * log10(2.0));
+
+  // batch meter levels against the table, same sweep as above
+  std::vector<double> sweep;
+  for (double db = -100.0; db <= 6.0; db += 0.0007) sweep.push_back(DB2VAL(db));
+  std::vector<int> batch(sweep.size());
+  Tpr_PeaksToLevels(&sweep[0], &batch[0], (int)sweep.size());
+
+  int lvl_off = 0, lvl_max = 0, step_off = 0;
+  double edge_db = 0.0;
+  for (size_t i = 0; i < sweep.size(); i++)
+  {
+    int ref = Ref_PeakToLevel(sweep[i]);
+    int d = abs(batch[i] - ref);
+    if (d == 0) continue;
+
+    lvl_off++;
+    if (d > lvl_max) lvl_max = d;
+    if (((batch[i] + 8) >> 4) != ((ref + 8) >> 4)) step_off++;
+
+    // how close to the level boundary between the two
+    double bound = -90.0 + 90.0 * (double)std::max(batch[i], ref) / (double)TPR_LEVELS;
+    double dist = fabs(VAL2DB(sweep[i]) - bound);
+    if (dist > edge_db) edge_db = dist;
+  }
+  printf("peak -> level, batch (%s): %d of %d differ, by at most %d, within %.1e dB of a boundary; %d ring steps differ\n",
+    path, lvl_off, (int)sweep.size(), lvl_max, edge_db, step_off);
+
+  // speed: 24 channel meter frames
+  const int frames = 100000;
+  double frame[24];
+  int levels[24];
+  for (int ch = 0; ch < 24; ch++) frame[ch] = DB2VAL(-60.0 + 2.5 * ch);
+
+  long lsum = 0;
+  t0 = Bench_Now();
+  for (int f = 0; f < frames; f++)
+  {
+    frame[f % 24] *= 1.0001;
+    for (int ch = 0; ch < 24; ch++) lsum += Ref_PeakToEncoder(frame[ch]);
+  }
+  double t_log = Bench_Now() - t0;
+  t0 = Bench_Now();
+  for (int f = 0; f < frames; f++)
+  {
+    frame[f % 24] *= 0.9999;
+    for (int ch = 0; ch < 24; ch++) lsum += Ref_PeakToLevel(frame[ch]);
+  }
+  double t_lvl = Bench_Now() - t0;
+  t0 = Bench_Now();
+  for (int f = 0; f < frames; f++)
+  {
+    frame[f % 24] *= 1.0001;
+    Tpr_PeaksToLevels(frame, levels, 24);
+    lsum += levels[f % 24];
+  }
+  double t_batch = Bench_Now() - t0;
+  printf("24 channel meter frame: log10 %.1f ns, table %.1f ns, batch (%s) %.1f ns (%d)\n",
+    t_log * 1000.0 / frames, t_lvl * 1000.0 / frames, path, t_batch * 1000.0 / frames, (int)lsum & 1);
+} // Bench_Taper
+
+
+// what the queue handed to the device
+struct BenchQueueLog
+{
+  std::vector<unsigned char> msgs; // status, d1, d2
+  long bytes, blocks;
+};
+
+class BenchQueueOutput : public midi_Output
+{
+public:
+  BenchQueueLog* log; // outlives the output, the queue deletes it
+
+  BenchQueueOutput(BenchQueueLog* l) { log = l; }
+
+  void SendMsg(MIDI_event_t* msg, int frame_offset)
+  {
+    log->bytes += msg->size;
+    log->blocks++;
+
+    unsigned char status = 0;
+    for (int i = 0; i + 1 < msg->size; )
+    {
+      if (msg->midi_message[i] & 0x80) { status = msg->midi_message[i++]; continue; }
+      log->msgs.push_back(status);
+      log->msgs.push_back(msg->midi_message[i]);
+      log->msgs.push_back(msg->midi_message[i + 1]);
+      i += 2;
+    }
+  }
+
+  void Send(unsigned char status, unsigned char d1, unsigned char d2, int frame_offset)
+  {
+    unsigned char evt[3] = { status, d1, d2 };
+    log->msgs.insert(log->msgs.end(), evt, evt + 3);
+    log->bytes += 3;
+    log->blocks++;
+  }
+};
+
+static int Bench_RingSet(unsigned char v)
+{
+  // what a ring value sets: level and level + over are the same display
+  int set = (v >> 4) & 7;
+  return (set == 6) ? 4 : set;
+}
+
+static void Bench_Queue()
+{
+  // a stalled UI thread catching up: 8 faders, 8 meters (hold, level / over) and a few buttons
+  // moving as fast as the producer can go, into a port paced at 3125 bytes/s
+  const int rate = 3125, steps = 2000;
+
+  BenchQueueLog log;
+  log.bytes = 0;
+  log.blocks = 0;
+  Out_Queue* q = new Out_Queue(new BenchQueueOutput(&log), rate);
+
+  int fdr[25], ring[24][8];
+  for (int i = 0; i < 25; i++) fdr[i] = -1;
+  for (int i = 0; i < 24; i++) for (int n = 0; n < 8; n++) ring[i][n] = -1;
+  std::vector<unsigned char> btns;
+  long produced = 0;
+
+  double t0 = Bench_Now();
+  for (int s = 0; s < steps; s++)
+  {
+    for (int ch = 0; ch < 8; ch++)
+    {
+      int v = (s * 37 + ch * 1000) & 0x3fff;
+      q->Send(0xb0, Prt_Out<PRT_FDRLSB>::CC(ch), v & 0x7f, 0);
+      q->Send(0xb0, Prt_Out<PRT_FDRMSB>::CC(ch), v >> 7, 0);
+      fdr[ch] = v;
+
+      // meter frame: hold, then level with the over led going on and off
+      int h = 0x10 + (s / 3 + ch) % 15;
+      int m = (s + ch) % 15 + ((((s / 7) + ch) & 1) ? 0x60 : 0x40);
+      q->Send(0xb0, Prt_Out<PRT_RING>::CC(ch), h, 0);
+      q->Send(0xb0, Prt_Out<PRT_RING>::CC(ch), m, 0);
+      ring[ch][Bench_RingSet(h)] = h;
+      ring[ch][Bench_RingSet(m)] = m;
+      produced += 12;
+    }
+
+    if (s % 20 == 0)
+    {
+      unsigned char b = Prt_Out<PRT_SEL>::CC((s / 20) % 24);
+      q->Send(0xb1, b, (s / 20) & 1 ? 0x7f : 0x00, 0);
+      btns.push_back(b);
+      produced += 3;
+    }
+  }
+  double t_send = Bench_Now() - t0;
+  long queued = q->m_queued, replaced = q->m_replaced, dropped = q->m_dropped;
+
+  while (!q->Out_Empty()) Sleep(1);
+  double t_drain = Bench_Now() - t0;
+
+  // idle: the worker should sleep until woken, not poll
+  Sleep(10);
+  long wake0 = q->m_wakeups;
+  Sleep(500);
+  long idle_wakeups = q->m_wakeups - wake0;
+  delete q; // joins the worker
+
+  // check: last fader / ring value wins, fader LSB comes right before its MSB,
+  // buttons in order and complete
+  int got_fdr[25], got_ring[24][8], lsb = -1, pair_bad = 0;
+  for (int i = 0; i < 25; i++) got_fdr[i] = -1;
+  for (int i = 0; i < 24; i++) for (int n = 0; n < 8; n++) got_ring[i][n] = -1;
+  std::vector<unsigned char> got_btns;
+
+  for (size_t i = 0; i + 2 < log.msgs.size(); i += 3)
+  {
+    unsigned char st = log.msgs[i], cc = log.msgs[i + 1], v = log.msgs[i + 2];
+    if (st == 0xb1) { got_btns.push_back(cc); continue; }
+
+    if (cc >= Prt_Out<PRT_FDRLSB>::CC(0) && cc <= Prt_Out<PRT_FDRLSB>::CC(24)) { lsb = v; continue; }
+    if (cc <= Prt_Out<PRT_FDRMSB>::CC(24))
+    {
+      if (lsb < 0) pair_bad++;
+      got_fdr[cc] = (v << 7) | (lsb & 0x7f);
+      lsb = -1;
+      continue;
+    }
+    if (cc >= Prt_Out<PRT_RING>::CC(0) && cc <= Prt_Out<PRT_RING>::CC(23))
+      got_ring[cc - Prt_Out<PRT_RING>::CC(0)][Bench_RingSet(v)] = v;
+  }
+
+  int stale = 0;
+  for (int i = 0; i < 25; i++) if (got_fdr[i] != fdr[i]) stale++;
+  for (int i = 0; i < 24; i++) for (int n = 0; n < 8; n++) if (got_ring[i][n] != ring[i][n]) stale++;
+
+  printf("output queue: %ld messages in %.0f us, %.0f ns per message\n", produced / 3, t_send, t_send * 3000.0 / produced);
+  printf("  %ld queued, %ld replaced, %ld dropped\n", queued, replaced, dropped);
+  printf("  sent %ld bytes in %ld blocks, drained after %.0f ms (FIFO: %.0f ms at %d bytes/s)\n",
+    log.bytes, log.blocks, t_drain / 1000.0, (double)produced * 1000.0 / rate, rate);
+  printf("  stale values: %d, split fader pairs: %d, buttons: %d of %d%s\n", stale, pair_bad,
+    (int)got_btns.size(), (int)btns.size(), (got_btns == btns) ? " in order" : " OUT OF ORDER");
+  printf("  idle worker: %ld wake-ups in 500 ms\n", idle_wakeups);
+
+  bool ok = (stale == 0) && (pair_bad == 0) && (got_btns == btns);
+  printf("latest value / fifo order: %s\n", ok ? "ok" : "FAILED");
+  printf("idle worker sleeps: %s\n", (idle_wakeups <= 10) ? "ok" : "FAILED");
+} // Bench_Queue
+
+
+static void Bench_Usage()
+{
+  printf("usage: bench_us2400 [options] [scenario ...]\n\n");
+  printf("  -t n    tracks (%d)\n", g_opts.proj.tracks);
+  printf("  -a n    aux buses (%d)\n", g_opts.proj.aux_buses);
+  printf("  -s n    sends per track (%d)\n", g_opts.proj.sends);
+  printf("  -x n    fx per track (%d)\n", g_opts.proj.fx);
+  printf("  -p n    params per fx (%d)\n", g_opts.proj.fx_params);
+  printf("  -c n    Run() cycles per scenario (%d)\n", g_opts.cycles);
+  printf("  -i n    isolated events timed for latency (%d)\n", g_opts.isolated);
+  printf("  -n n    top api calls listed per scenario (%d)\n", g_opts.top);
+  printf("  -r file replay file for the 'replay' scenario\n");
+  printf("  -w      scribble strip open\n");
+  printf("  -k      m-key mode (no meters)\n");
+  printf("  -j ms   Run() period jitter, 1/30 s -/+ ms alternating (0)\n");
+  printf("  -e      no host echo (CSurf_On*Change doesn't call back)\n");
+  printf("  -q      quick run (100 cycles, 100 events)\n");
+  printf("  -P      protocol only: check and time the decode table\n");
+  printf("  -T      taper only: check and time the volume tables\n");
+  printf("  -Q      output queue only: stall and catch up against a paced port\n\n");
+  printf("scenarios:\n");
+  for (int i = 0; g_scenarios[i].name; i++) printf("  %-11s %s\n", g_scenarios[i].name, g_scenarios[i].desc);
+}
+
+
+int main(int argc, char** argv)
+{
+  g_opts.proj.tracks = 64;
+  g_opts.proj.aux_buses = 6;
+  g_opts.proj.sends = 4;
+  g_opts.proj.hwouts = 0;
+  g_opts.proj.fx = 4;
+  g_opts.proj.fx_params = 32;
+  g_opts.proj.notify = true;
+  g_opts.cycles = 600;
+  g_opts.isolated = 1000;
+  g_opts.top = 5;
+  g_opts.strip = false;
+  g_opts.mkey = false;
+  g_opts.jitter = 0.0;
+  g_opts.replay = NULL;
+
+  std::vector<const Scenario*> run;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char* a = argv[i];
+    bool has_val = (i + 1 < argc);
+
+    if (!strcmp(a, "-h") || !strcmp(a, "--help")) { Bench_Usage(); return 0; }
+    else if (!strcmp(a, "-t") && has_val) g_opts.proj.tracks = atoi(argv[++i]);
+    else if (!strcmp(a, "-a") && has_val) g_opts.proj.aux_buses = atoi(argv[++i]);
+    else if (!strcmp(a, "-s") && has_val) g_opts.proj.sends = atoi(argv[++i]);
+    else if (!strcmp(a, "-x") && has_val) g_opts.proj.fx = atoi(argv[++i]);
+    else if (!strcmp(a, "-p") && has_val) g_opts.proj.fx_params = atoi(argv[++i]);
+    else if (!strcmp(a, "-c") && has_val) g_opts.cycles = atoi(argv[++i]);
+    else if (!strcmp(a, "-i") && has_val) g_opts.isolated = atoi(argv[++i]);
+    else if (!strcmp(a, "-n") && has_val) g_opts.top = atoi(argv[++i]);
+    else if (!strcmp(a, "-r") && has_val) g_opts.replay = argv[++i];
+    else if (!strcmp(a, "-w")) g_opts.strip = true;
+    else if (!strcmp(a, "-k")) g_opts.mkey = true;
+    else if (!strcmp(a, "-j") && has_val) g_opts.jitter = atof(argv[++i]);
+    else if (!strcmp(a, "-e")) g_opts.proj.notify = false;
+    else if (!strcmp(a, "-q")) { g_opts.cycles = 100; g_opts.isolated = 100; }
+    else if (!strcmp(a, "-P")) { Bench_Protocol(); return 0; }
+    else if (!strcmp(a, "-T")) { Bench_Taper(); return 0; }
+    else if (!strcmp(a, "-Q")) { Bench_Queue(); return 0; }
+    else
+    {
+      const Scenario* scn = NULL;
+      for (int s = 0; g_scenarios[s].name; s++)
+        if (!strcmp(g_scenarios[s].name, a)) scn = &g_scenarios[s];
+
+      if (!scn)
+      {
+        fprintf(stderr, "bench: unknown option or scenario '%s'\n\n", a);
+        Bench_Usage();
+        return 1;
+      }
+      run.push_back(scn);
+    }
+  }
+
+  if (g_opts.proj.aux_buses > g_opts.proj.tracks) g_opts.proj.aux_buses = g_opts.proj.tracks;
+  if (g_opts.cycles < 1) g_opts.cycles = 1;
+
+  if (g_opts.replay && !Bench_LoadReplay(g_opts.replay))
+  {
+    fprintf(stderr, "bench: can't read replay file '%s'\n", g_opts.replay);
+    return 1;
+  }
+
+  // default: everything but replay, unless a file was given
+  if (run.empty())
+    for (int s = 0; g_scenarios[s].name; s++)
+      if (strcmp(g_scenarios[s].name, "replay") || g_opts.replay) run.push_back(&g_scenarios[s]);
+
+  printf("US-2400 bench: %d tracks, %d aux, %d sends, %d fx x %d params, %d cycles%s%s%s\n\n",
+    g_opts.proj.tracks, g_opts.proj.aux_buses, g_opts.proj.sends, g_opts.proj.fx, g_opts.proj.fx_params,
+    g_opts.cycles, g_opts.strip ? ", strip open" : "", g_opts.proj.notify ? "" : ", no host echo",
+    g_opts.mkey ? ", m-key mode" : "");
+
+  printf("%-11s %7s %8s %8s %8s %8s %8s %8s %9s %8s %8s %6s\n",
+    "scenario", "evt/cyc", "run p50", "run p90", "run p99", "run max", "evt p50", "evt p99",
+    "api/cyc", "msgs/cyc", "byte/cyc", "sends");
+  printf("%-11s %7s %8s %8s %8s %8s %8s %8s %9s %8s %8s %6s\n",
+    "", "", "us", "us", "us", "us", "us", "us", "", "", "", "/cyc");
+
+  for (size_t i = 0; i < run.size(); i++) Bench_Scenario(run[i]);
+
+  return 0;
+} // main
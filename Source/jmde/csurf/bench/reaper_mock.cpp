@@ -0,0 +1,1104 @@
+/*
+** US-2400 bench harness
+** In-memory mock of the REAPER host API
+*/
+
+#include "reaper_mock.h"
+#include "../../../WDL/db2val.h"
+#include <map>
+#include <algorithm>
+
+
+////// STATE //////
+
+static std::vector<MockTrack*> g_tracks; // 0 = master
+static MockProjectCfg g_cfg;
+static IReaperControlSurface* g_surface = NULL;
+static reaper_csurf_reg_t* g_csurf_reg = NULL;
+
+static std::map<std::string, long> g_counts;
+static std::map<std::string, std::string> g_extstate;
+
+static double g_playpos = 0.0;
+static double g_cursorpos = 0.0;
+static int g_repeat = 0;
+static int g_playstate = 0;
+
+static int g_csurf_rate = 30;
+static int g_zoommode = 0;
+
+static long g_out_msgs = 0;
+static long g_out_bytes = 0;
+static long g_out_flushes = 0;
+static long g_out_badbytes = 0; // data bytes >= 0x80 break the running status
+
+static long* Mock_Counter(const char* name)
+{
+  return &g_counts[name];
+}
+
+#define HIT() do { static long* s_cnt = Mock_Counter(__func__); ++*s_cnt; } while (0)
+
+
+static MockTrack* Tk(MediaTrack* tr)
+{
+  // the surface only ever holds pointers handed out by the mock (or NULL)
+  return (MockTrack*)tr;
+}
+
+static MediaTrack* Mt(int idx)
+{
+  if ((idx < 0) || (idx >= (int)g_tracks.size())) return NULL;
+  return (MediaTrack*)g_tracks[idx];
+}
+
+static MockSend* Snd(MockTrack* tk, int send_index)
+{
+  // hardware outputs first, then sends (see GetTrackSendUIVolPan)
+  if (!tk || send_index < 0) return NULL;
+  if (send_index < (int)tk->hwouts.size()) return &tk->hwouts[send_index];
+  send_index -= tk->hwouts.size();
+  if (send_index < (int)tk->sends.size()) return &tk->sends[send_index];
+  return NULL;
+}
+
+
+////// MIDI DEVICES //////
+
+class MockEventList : public MIDI_eventlist
+{
+public:
+  std::vector<MIDI_event_t> m_evts;
+
+  void AddItem(MIDI_event_t* evt) { m_evts.push_back(*evt); }
+  MIDI_event_t* EnumItems(int* bpos)
+  {
+    if (*bpos < 0 || *bpos >= (int)m_evts.size()) return NULL;
+    return &m_evts[(*bpos)++];
+  }
+  void DeleteItem(int bpos) { if (bpos >= 0 && bpos < (int)m_evts.size()) m_evts.erase(m_evts.begin() + bpos); }
+  int GetSize() { return (int)(m_evts.size() * sizeof(MIDI_event_t)); }
+  void Empty() { m_evts.clear(); }
+};
+
+class MockMIDIInput;
+static MockMIDIInput* g_midiin = NULL;
+
+class MockMIDIInput : public midi_Input
+{
+public:
+  MockEventList m_pending, m_read;
+
+  virtual ~MockMIDIInput() { if (g_midiin == this) g_midiin = NULL; }
+
+  void start() { }
+  void stop() { }
+  void SwapBufs(unsigned int timestamp)
+  {
+    m_read.m_evts.swap(m_pending.m_evts);
+    m_pending.Empty();
+  }
+  MIDI_eventlist* GetReadBuf() { return &m_read; }
+};
+
+class MockMIDIOutput : public midi_Output
+{
+public:
+  void SendMsg(MIDI_event_t* msg, int frame_offset)
+  {
+    if (!msg) return;
+    g_out_flushes++;
+    g_out_bytes += msg->size;
+
+    // count messages, honouring running status
+    int i = 0;
+    while (i < msg->size)
+    {
+      if (msg->midi_message[i] & 0x80) i++;
+      for (int d = i; (d < i + 2) && (d < msg->size); d++)
+        if (msg->midi_message[d] & 0x80) g_out_badbytes++;
+      i += 2;
+      g_out_msgs++;
+    }
+  }
+
+  void Send(unsigned char status, unsigned char d1, unsigned char d2, int frame_offset)
+  {
+    g_out_flushes++;
+    g_out_msgs++;
+    g_out_bytes += 3;
+  }
+};
+
+
+
+////// API //////
+
+namespace mock_api {
+
+// ADDITIONS FOR US-2400
+
+void ShowConsoleMsg(const char* msg) { HIT(); if (getenv("US2400_BENCH_CONSOLE")) fputs(msg, stderr); }
+
+double GetMediaTrackInfo_Value(MediaTrack* tr, const char* parmname)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk) return 0.0;
+  if (!strcmp(parmname, "IP_TRACKNUMBER")) return tk->idx == 0 ? -1.0 : (double)tk->idx;
+  if (!strcmp(parmname, "D_VOL")) return tk->vol;
+  if (!strcmp(parmname, "D_PAN")) return tk->pan;
+  if (!strcmp(parmname, "D_WIDTH")) return tk->width;
+  if (!strcmp(parmname, "B_PHASE")) return tk->phase;
+  if (!strcmp(parmname, "B_MUTE")) return tk->mute;
+  if (!strcmp(parmname, "I_SOLO")) return tk->solo;
+  if (!strcmp(parmname, "I_RECARM")) return tk->recarm;
+  if (!strcmp(parmname, "I_FXEN")) return tk->fxen;
+  if (!strcmp(parmname, "I_SELECTED")) return tk->sel;
+  if (!strcmp(parmname, "I_AUTOMODE")) return tk->automode;
+  return 0.0;
+}
+
+bool SetMediaTrackInfo_Value(MediaTrack* tr, const char* parmname, double newvalue)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk) return false;
+  if (!strcmp(parmname, "D_VOL")) tk->vol = newvalue;
+  else if (!strcmp(parmname, "D_PAN")) tk->pan = newvalue;
+  else if (!strcmp(parmname, "D_WIDTH")) tk->width = newvalue;
+  else if (!strcmp(parmname, "B_PHASE")) tk->phase = newvalue != 0.0;
+  else if (!strcmp(parmname, "B_MUTE")) tk->mute = newvalue != 0.0;
+  else if (!strcmp(parmname, "I_SOLO")) tk->solo = (int)newvalue;
+  else if (!strcmp(parmname, "I_RECARM")) tk->recarm = (int)newvalue;
+  else if (!strcmp(parmname, "I_FXEN")) tk->fxen = (int)newvalue;
+  else return false;
+  return true;
+}
+
+int CountTracks(ReaProject* proj) { HIT(); return (int)g_tracks.size() - 1; }
+MediaTrack* GetTrack(ReaProject* proj, int trackidx) { HIT(); return Mt(trackidx + 1); }
+
+bool AnyTrackSolo(ReaProject* proj)
+{
+  HIT();
+  for (size_t i = 1; i < g_tracks.size(); i++)
+    if (g_tracks[i]->solo) return true;
+  return false;
+}
+
+MediaTrack* SetMixerScroll(MediaTrack* leftmosttrack) { HIT(); return leftmosttrack; }
+void Main_OnCommandEx(int command, int flag, ReaProject* proj) { HIT(); }
+void CSurf_OnZoom(int xdir, int ydir) { HIT(); }
+void CSurf_OnScroll(int xdir, int ydir) { HIT(); }
+
+int CountSelectedTracks(ReaProject* proj)
+{
+  HIT();
+  int n = 0;
+  for (size_t i = 1; i < g_tracks.size(); i++)
+    if (g_tracks[i]->sel) n++;
+  return n;
+}
+
+bool IsTrackSelected(MediaTrack* track) { HIT(); MockTrack* tk = Tk(track); return tk ? tk->sel : false; }
+
+double CSurf_OnSendPanChange(MediaTrack* trackid, int send_index, double pan, bool relative)
+{
+  HIT();
+  MockSend* s = Snd(Tk(trackid), send_index);
+  if (!s) return 0.0;
+  s->pan = relative ? s->pan + pan : pan;
+  return s->pan;
+}
+
+double CSurf_OnSendVolumeChange(MediaTrack* trackid, int send_index, double volume, bool relative)
+{
+  HIT();
+  MockSend* s = Snd(Tk(trackid), send_index);
+  if (!s) return 0.0;
+  s->vol = relative ? s->vol + volume : volume;
+  return s->vol;
+}
+
+void* GetSetTrackSendInfo(MediaTrack* tr, int category, int sendidx, const char* parmname, void* setNewValue)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk) return NULL;
+  MockSend* s = NULL;
+  if (category == -1)
+  {
+    // receives: the sends of other tracks to this one, in track order
+    int n = 0;
+    for (size_t t = 0; t < g_tracks.size(); t++)
+      for (size_t i = 0; i < g_tracks[t]->sends.size(); i++)
+        if ( (g_tracks[t]->sends[i].dest == tk->idx) && (n++ == sendidx) )
+        {
+          if (!strcmp(parmname, "P_SRCTRACK")) return (void*)g_tracks[t];
+          s = &g_tracks[t]->sends[i];
+        }
+  }
+  else if (category == 0 && sendidx >= 0 && sendidx < (int)tk->sends.size()) s = &tk->sends[sendidx];
+  else if (category == 1 && sendidx >= 0 && sendidx < (int)tk->hwouts.size()) s = &tk->hwouts[sendidx];
+  if (!s) return NULL;
+  if (!strcmp(parmname, "I_SENDMODE")) return &s->mode;
+  if (!strcmp(parmname, "P_DESTTRACK")) return (s->dest >= 0 && s->dest < (int)g_tracks.size()) ? (void*)g_tracks[s->dest] : NULL;
+  if (!strcmp(parmname, "D_VOL")) return &s->vol;
+  if (!strcmp(parmname, "D_PAN")) return &s->pan;
+  return NULL;
+}
+
+bool TrackFX_GetEnabled(MediaTrack* track, int fx)
+{
+  HIT();
+  MockTrack* tk = Tk(track);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size()) return false;
+  return tk->fx[fx].enabled;
+}
+
+void TrackFX_SetEnabled(MediaTrack* track, int fx, bool enabled)
+{
+  HIT();
+  MockTrack* tk = Tk(track);
+  if (tk && fx >= 0 && fx < (int)tk->fx.size()) tk->fx[fx].enabled = enabled;
+}
+
+void TrackFX_Show(MediaTrack* track, int index, int showFlag) { HIT(); }
+ReaProject* EnumProjects(int idx, char* projfn, int projfnlen) { HIT(); return idx <= 0 ? (ReaProject*)&g_cfg : NULL; }
+
+void GetSet_LoopTimeRange(bool isSet, bool isLoop, double* start, double* end, bool allowautoseek)
+{
+  HIT();
+  static double s = 0.0, e = 0.0;
+  if (isSet) { s = *start; e = *end; }
+  else { *start = s; *end = e; }
+}
+
+int EnumProjectMarkers(int idx, bool* isrgn, double* pos, double* rgnend, char** name, int* markrgnindexnumber) { HIT(); return 0; }
+
+void TimeMap_GetTimeSigAtTime(ReaProject* proj, double time, int* timesig_num, int* timesig_denom, double* tempo)
+{
+  HIT();
+  if (timesig_num) *timesig_num = 4;
+  if (timesig_denom) *timesig_denom = 4;
+  if (tempo) *tempo = 120.0;
+}
+
+double TimeMap2_timeToQN(ReaProject* proj, double tpos) { HIT(); return tpos * 2.0; }
+double TimeMap2_QNToTime(ReaProject* proj, double qn) { HIT(); return qn * 0.5; }
+double SnapToGrid(ReaProject* project, double time_pos) { HIT(); return time_pos; }
+void SetEditCurPos2(ReaProject* proj, double time, bool moveview, bool seekplay) { HIT(); g_cursorpos = time; }
+
+double CSurf_OnWidthChange(MediaTrack* trackid, double width, bool relative)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return 0.0;
+  tk->width = relative ? tk->width + width : width;
+  return tk->width;
+}
+
+MediaTrack* GetSelectedTrack(ReaProject* proj, int seltrackidx)
+{
+  HIT();
+  for (size_t i = 1; i < g_tracks.size(); i++)
+    if (g_tracks[i]->sel && seltrackidx-- == 0) return (MediaTrack*)g_tracks[i];
+  return NULL;
+}
+
+void TrackFX_SetOpen(MediaTrack* track, int fx, bool open) { HIT(); }
+
+void SetTrackSelected(MediaTrack* tr, bool sel);
+
+void SetOnlyTrackSelected(MediaTrack* track)
+{
+  HIT();
+  for (size_t i = 0; i < g_tracks.size(); i++)
+    SetTrackSelected((MediaTrack*)g_tracks[i], (MediaTrack*)g_tracks[i] == track);
+}
+
+MediaTrack* GetMasterTrack(ReaProject* proj) { HIT(); return Mt(0); }
+void DeleteTrack(MediaTrack* tr) { HIT(); }
+
+const char* GetTrackState(MediaTrack* track, int* flags)
+{
+  HIT();
+  MockTrack* tk = Tk(track);
+  if (!tk) { if (flags) *flags = 0; return ""; }
+  if (flags)
+  {
+    *flags = 0;
+    if (tk->sel) *flags |= 2;
+    if (tk->fxen) *flags |= 4;
+    if (tk->mute) *flags |= 8;
+    if (tk->solo) *flags |= 16;
+    if (tk->recarm) *flags |= 64;
+  }
+  return tk->name.c_str();
+}
+
+int NamedCommandLookup(const char* command_name) { HIT(); return 0; }
+
+int GetTrackNumSends(MediaTrack* tr, int category)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk) return 0;
+  if (category == 0) return (int)tk->sends.size();
+  if (category == 1) return (int)tk->hwouts.size();
+  int recv = 0;
+  for (size_t i = 1; i < g_tracks.size(); i++)
+    for (size_t s = 0; s < g_tracks[i]->sends.size(); s++)
+      if (g_tracks[i]->sends[s].dest == tk->idx) recv++;
+  return recv;
+}
+
+bool GetTrackSendName(MediaTrack* track, int send_index, char* buf, int buflen)
+{
+  HIT();
+  MockTrack* tk = Tk(track);
+  MockSend* s = Snd(tk, send_index);
+  if (!s) { if (buflen > 0) buf[0] = 0; return false; }
+  if (s->dest < 0) snprintf(buf, buflen, "Output %d", send_index + 1);
+  else snprintf(buf, buflen, "%s", g_tracks[s->dest]->name.c_str());
+  return true;
+}
+
+void Main_OnCommand(int command, int flag) { HIT(); }
+MediaTrack* GetLastTouchedTrack() { HIT(); return Mt(1); }
+
+bool GetTrackSendUIVolPan(MediaTrack* track, int send_index, double* volume, double* pan)
+{
+  HIT();
+  MockSend* s = Snd(Tk(track), send_index);
+  if (!s) return false;
+  if (volume) *volume = s->vol;
+  if (pan) *pan = s->pan;
+  return true;
+}
+
+bool TrackFX_GetParameterStepSizes(MediaTrack* track, int fx, int param, double* step, double* smallstep, double* largestep, bool* istoggle)
+{
+  HIT();
+  return false;
+}
+
+const char* kbd_getTextFromCmd(DWORD cmd, KbdSectionInfo* section) { HIT(); return ""; }
+
+bool GetSetMediaTrackInfo_String(MediaTrack* tr, const char* parmname, char* string, bool setnewvalue)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk || strcmp(parmname, "P_NAME")) return false;
+  if (setnewvalue) tk->name = string;
+  else strcpy(string, tk->name.c_str()); // like REAPER: caller provides the buffer
+  return true;
+}
+
+const char* GetResourcePath() { HIT(); return "."; }
+
+bool TrackFX_GetFormattedParamValue(MediaTrack* track, int fx, int param, char* buf, int buflen)
+{
+  HIT();
+  MockTrack* tk = Tk(track);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size() || param < 0 || param >= (int)tk->fx[fx].params.size())
+  {
+    if (buflen > 0) buf[0] = 0;
+    return false;
+  }
+  snprintf(buf, buflen, "%.1f%%", tk->fx[fx].params[param] * 100.0);
+  return true;
+}
+
+int GetTrackColor(MediaTrack* track) { HIT(); MockTrack* tk = Tk(track); return tk ? tk->color : 0; }
+bool HasExtState(const char* section, const char* key) { HIT(); return g_extstate.count(std::string(section) + "/" + key) > 0; }
+
+const char* GetExtState(const char* section, const char* key)
+{
+  HIT();
+  std::map<std::string, std::string>::iterator it = g_extstate.find(std::string(section) + "/" + key);
+  return it == g_extstate.end() ? "" : it->second.c_str();
+}
+
+void SetExtState(const char* section, const char* key, const char* value, bool persist) { HIT(); g_extstate[std::string(section) + "/" + key] = value; }
+void Undo_BeginBlock() { HIT(); }
+void Undo_EndBlock(const char* descchange, int extraflags) { HIT(); }
+
+double Track_GetPeakHoldDB(MediaTrack* track, int channel, bool clear)
+{
+  HIT();
+  MockTrack* tk = Tk(track);
+  if (!tk || channel < 0 || channel > 1) return -1.5;
+  double hold = tk->hold_db[channel];
+  if (clear) tk->hold_db[channel] = -150.0;
+  return hold / 100.0; // REAPER returns dB * 0.01
+}
+
+char* GetSetObjectState(void* obj, const char* str)
+{
+  HIT();
+  if (str && *str) return NULL;
+  char* chunk = (char*)malloc(64);
+  strcpy(chunk, "<TRACK\nMIDIOUT -1\n>\n");
+  return chunk;
+}
+
+void FreeHeapPtr(void* ptr) { HIT(); free(ptr); }
+void TrackList_AdjustWindows(bool isMajor) { HIT(); }
+
+// ADDITIONS FOR US-2400 -- END
+
+
+// stand-in for REAPER's fader taper: monotone, 0..1000 <-> -150..+12 dB
+double SLIDER2DB(double y)
+{
+  HIT();
+  if (y <= 0.0) return -150.0;
+  if (y >= 1000.0) return 12.0;
+  double x = 1.0 - y / 1000.0;
+  return 12.0 - 162.0 * pow(x, 2.5);
+}
+
+double DB2SLIDER(double x)
+{
+  HIT();
+  if (x >= 12.0) return 1000.0;
+  if (x <= -150.0) return 0.0;
+  return 1000.0 * (1.0 - pow((12.0 - x) / 162.0, 1.0 / 2.5));
+}
+
+int GetNumMIDIInputs() { HIT(); return 1; }
+int GetNumMIDIOutputs() { HIT(); return 1; }
+
+midi_Input* CreateMIDIInput(int dev)
+{
+  HIT();
+  g_midiin = new MockMIDIInput;
+  return g_midiin;
+}
+
+midi_Output* CreateMIDIOutput(int dev, bool streamMode, int* msoffset100) { HIT(); return new MockMIDIOutput; }
+bool GetMIDIOutputName(int dev, char* nameout, int nameoutlen) { HIT(); snprintf(nameout, nameoutlen, "US-2400 mock"); return true; }
+bool GetMIDIInputName(int dev, char* nameout, int nameoutlen) { HIT(); snprintf(nameout, nameoutlen, "US-2400 mock"); return true; }
+
+int CSurf_TrackToID(MediaTrack* track, bool mcpView) { HIT(); MockTrack* tk = Tk(track); return tk ? tk->idx : -1; }
+MediaTrack* CSurf_TrackFromID(int idx, bool mcpView) { HIT(); return Mt(idx); }
+int CSurf_NumTracks(bool mcpView) { HIT(); return (int)g_tracks.size() - 1; }
+
+void CSurf_SetTrackListChange() { HIT(); }
+void CSurf_SetSurfaceVolume(MediaTrack* trackid, double volume, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetSurfacePan(MediaTrack* trackid, double pan, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetSurfaceMute(MediaTrack* trackid, bool mute, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetSurfaceSelected(MediaTrack* trackid, bool selected, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetSurfaceSolo(MediaTrack* trackid, bool solo, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetSurfaceRecArm(MediaTrack* trackid, bool recarm, IReaperControlSurface* ignoresurf) { HIT(); }
+bool CSurf_GetTouchState(MediaTrack* trackid, int isPan) { HIT(); return false; }
+void CSurf_SetAutoMode(int mode, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetPlayState(bool play, bool pause, bool rec, IReaperControlSurface* ignoresurf) { HIT(); }
+void CSurf_SetRepeatState(bool rep, IReaperControlSurface* ignoresurf) { HIT(); }
+
+// surface initiated changes, REAPER echoes them to all surfaces
+
+double CSurf_OnVolumeChange(MediaTrack* trackid, double volume, bool relative)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return 0.0;
+  tk->vol = relative ? tk->vol + volume : volume;
+  if (g_surface && g_cfg.notify) g_surface->SetSurfaceVolume(trackid, tk->vol);
+  return tk->vol;
+}
+
+double CSurf_OnPanChange(MediaTrack* trackid, double pan, bool relative)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return 0.0;
+  tk->pan = relative ? tk->pan + pan : pan;
+  if (tk->pan < -1.0) tk->pan = -1.0;
+  if (tk->pan > 1.0) tk->pan = 1.0;
+  if (g_surface && g_cfg.notify) g_surface->SetSurfacePan(trackid, tk->pan);
+  return tk->pan;
+}
+
+bool CSurf_OnMuteChange(MediaTrack* trackid, int mute)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return false;
+  tk->mute = mute < 0 ? !tk->mute : mute != 0;
+  if (g_surface && g_cfg.notify) g_surface->SetSurfaceMute(trackid, tk->mute);
+  return tk->mute;
+}
+
+bool CSurf_OnSelectedChange(MediaTrack* trackid, int selected)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return false;
+  tk->sel = selected < 0 ? !tk->sel : selected != 0;
+  if (g_surface && g_cfg.notify) g_surface->SetSurfaceSelected(trackid, tk->sel);
+  return tk->sel;
+}
+
+bool CSurf_OnSoloChange(MediaTrack* trackid, int solo)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return false;
+  tk->solo = solo < 0 ? (tk->solo ? 0 : 2) : solo;
+  if (g_surface && g_cfg.notify) g_surface->SetSurfaceSolo(trackid, tk->solo != 0);
+  return tk->solo != 0;
+}
+
+bool CSurf_OnFXChange(MediaTrack* trackid, int en)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return false;
+  tk->fxen = en < 0 ? !tk->fxen : en;
+  return tk->fxen != 0;
+}
+
+bool CSurf_OnRecArmChange(MediaTrack* trackid, int recarm)
+{
+  HIT();
+  MockTrack* tk = Tk(trackid);
+  if (!tk) return false;
+  tk->recarm = recarm < 0 ? !tk->recarm : recarm;
+  if (g_surface && g_cfg.notify) g_surface->SetSurfaceRecArm(trackid, tk->recarm != 0);
+  return tk->recarm != 0;
+}
+
+void CSurf_OnPlay() { HIT(); g_playstate = 1; }
+void CSurf_OnStop() { HIT(); g_playstate = 0; }
+void CSurf_OnFwd(int seekplay) { HIT(); }
+void CSurf_OnRew(int seekplay) { HIT(); }
+void CSurf_OnRecord() { HIT(); }
+void CSurf_GoStart() { HIT(); }
+void CSurf_GoEnd() { HIT(); }
+void CSurf_OnArrow(int whichdir, bool wantzoom) { HIT(); }
+void CSurf_OnTrackSelection(MediaTrack* trackid) { HIT(); }
+void CSurf_ResetAllCachedVolPanStates() { HIT(); }
+void CSurf_ScrubAmt(double amt) { HIT(); g_playpos += amt * 0.01; }
+
+void TrackList_UpdateAllExternalSurfaces()
+{
+  HIT();
+  if (!g_surface) return;
+  for (size_t i = 0; i < g_tracks.size(); i++)
+  {
+    MediaTrack* tr = (MediaTrack*)g_tracks[i];
+    g_surface->SetSurfaceVolume(tr, g_tracks[i]->vol);
+    g_surface->SetSurfacePan(tr, g_tracks[i]->pan);
+  }
+}
+
+void kbd_OnMidiEvent(MIDI_event_t* evt, int dev_index) { HIT(); }
+int GetMasterMuteSoloFlags() { HIT(); return 0; }
+void ClearAllRecArmed() { HIT(); }
+void SetTrackAutomationMode(MediaTrack* tr, int mode) { HIT(); MockTrack* tk = Tk(tr); if (tk) tk->automode = mode; }
+int GetTrackAutomationMode(MediaTrack* tr) { HIT(); MockTrack* tk = Tk(tr); return tk ? tk->automode : 0; }
+
+void SoloAllTracks(int solo)
+{
+  HIT();
+  for (size_t i = 1; i < g_tracks.size(); i++)
+  {
+    g_tracks[i]->solo = solo;
+    if (g_surface) g_surface->SetSurfaceSolo((MediaTrack*)g_tracks[i], solo != 0);
+  }
+}
+
+void MuteAllTracks(bool mute)
+{
+  HIT();
+  for (size_t i = 1; i < g_tracks.size(); i++)
+  {
+    g_tracks[i]->mute = mute;
+    if (g_surface) g_surface->SetSurfaceMute((MediaTrack*)g_tracks[i], mute);
+  }
+}
+
+void BypassFxAllTracks(int bypass) { HIT(); }
+
+const char* GetTrackInfo(INT_PTR track, int* flags)
+{
+  HIT();
+  return GetTrackState(Mt((int)track + 1), flags);
+}
+
+void SetTrackSelected(MediaTrack* tr, bool sel)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk || tk->sel == sel) return;
+  tk->sel = sel;
+  if (g_surface) g_surface->SetSurfaceSelected(tr, sel);
+}
+
+void SetAutomationMode(int mode, bool onlySel) { HIT(); }
+void UpdateTimeline() { HIT(); }
+void Main_UpdateLoopInfo(int ignoremask) { HIT(); }
+int GetPlayState() { HIT(); return g_playstate; }
+double GetPlayPosition() { HIT(); return g_playpos; }
+double GetCursorPosition() { HIT(); return g_cursorpos; }
+void format_timestr_pos(double tpos, char* buf, int buflen, int modeoverride) { HIT(); snprintf(buf, buflen, "%.3f", tpos); }
+
+double TimeMap2_timeToBeats(void* proj, double tpos, int* measures, int* cml, double* fullbeats, int* cdenom)
+{
+  HIT();
+  if (measures) *measures = (int)(tpos / 2.0);
+  if (cml) *cml = 4;
+  if (fullbeats) *fullbeats = tpos * 2.0;
+  if (cdenom) *cdenom = 4;
+  return fmod(tpos * 2.0, 4.0);
+}
+
+double Track_GetPeakInfo(MediaTrack* tr, int chidx)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk || chidx < 0 || chidx > 1) return 0.0;
+  return tk->peak[chidx];
+}
+
+bool GetTrackUIVolPan(MediaTrack* tr, double* vol, double* pan)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk) return false;
+  if (vol) *vol = tk->vol;
+  if (pan) *pan = tk->pan;
+  return true;
+}
+
+int GetSetRepeat(int val)
+{
+  HIT();
+  if (val == 2) g_repeat = !g_repeat;
+  else if (val >= 0) g_repeat = val;
+  return g_repeat;
+}
+
+void mkvolpanstr(char* str, double vol, double pan) { HIT(); sprintf(str, "%.2f %.2f", vol, pan); }
+void mkvolstr(char* str, double vol) { HIT(); sprintf(str, "%.2f", vol); }
+void mkpanstr(char* str, double pan) { HIT(); sprintf(str, "%.2f", pan); }
+void MoveEditCursor(double adjamt, bool dosel) { HIT(); g_cursorpos += adjamt; }
+void adjustZoom(double amt, int forceset, bool doupd, int centermode) { HIT(); }
+double GetHZoomLevel() { HIT(); return 100.0; }
+
+int TrackFX_GetCount(MediaTrack* tr) { HIT(); MockTrack* tk = Tk(tr); return tk ? (int)tk->fx.size() : 0; }
+
+int TrackFX_GetNumParams(MediaTrack* tr, int fx)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size()) return 0;
+  return (int)tk->fx[fx].params.size();
+}
+
+double TrackFX_GetParam(MediaTrack* tr, int fx, int param, double* minval, double* maxval)
+{
+  HIT();
+  if (minval) *minval = 0.0;
+  if (maxval) *maxval = 1.0;
+  MockTrack* tk = Tk(tr);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size() || param < 0 || param >= (int)tk->fx[fx].params.size()) return 0.0;
+  return tk->fx[fx].params[param];
+}
+
+bool TrackFX_SetParam(MediaTrack* tr, int fx, int param, double val)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size() || param < 0 || param >= (int)tk->fx[fx].params.size()) return false;
+  tk->fx[fx].params[param] = val;
+  return true;
+}
+
+bool TrackFX_GetParamName(MediaTrack* tr, int fx, int param, char* buf, int buflen)
+{
+  HIT();
+  snprintf(buf, buflen, "Param %d", param + 1);
+  return true;
+}
+
+bool TrackFX_FormatParamValue(MediaTrack* tr, int fx, int param, double val, char* buf, int buflen)
+{
+  HIT();
+  snprintf(buf, buflen, "%.1f%%", val * 100.0);
+  return true;
+}
+
+bool TrackFX_GetFXName(MediaTrack* tr, int fx, char* buf, int buflen)
+{
+  HIT();
+  MockTrack* tk = Tk(tr);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size()) { if (buflen > 0) buf[0] = 0; return false; }
+  snprintf(buf, buflen, "%s", tk->fx[fx].name.c_str());
+  return true;
+}
+
+GUID* GetTrackGUID(MediaTrack* tr) { HIT(); MockTrack* tk = Tk(tr); return tk ? &tk->guid : NULL; }
+
+void* get_config_var(const char* name, int* szout)
+{
+  HIT();
+  *szout = sizeof(int);
+  if (!strcmp(name, "csurfrate")) return &g_csurf_rate;
+  if (!strcmp(name, "zoommode")) return &g_zoommode;
+  return NULL;
+}
+
+int projectconfig_var_getoffs(const char* name, int* szout)
+{
+  HIT();
+  static const char* names[] = { "projtimemode", "projtimemode2", "projtimeoffs", "projmeasoffs" };
+  for (int i = 0; i < 4; i++)
+  {
+    if (!strcmp(name, names[i]))
+    {
+      *szout = (i == 2) ? sizeof(double) : sizeof(int);
+      return 8 * (i + 1);
+    }
+  }
+  return 0;
+}
+
+void* projectconfig_var_addr(void* proj, int idx)
+{
+  HIT();
+  static double vars[8];
+  return &vars[(idx / 8) & 7];
+}
+
+} // namespace mock_api
+
+
+////// GETFUNC //////
+
+struct MockFunc
+{
+  const char* name;
+  void* func;
+};
+
+#define MOCKFUNC(x) { #x, (void*)&mock_api::x },
+
+static const MockFunc g_funcs[] =
+{
+  MOCKFUNC(ShowConsoleMsg) MOCKFUNC(GetMediaTrackInfo_Value) MOCKFUNC(SetMediaTrackInfo_Value)
+  MOCKFUNC(CountTracks) MOCKFUNC(GetTrack) MOCKFUNC(AnyTrackSolo) MOCKFUNC(SetMixerScroll)
+  MOCKFUNC(Main_OnCommandEx) MOCKFUNC(CSurf_OnZoom) MOCKFUNC(CSurf_OnScroll) MOCKFUNC(CountSelectedTracks)
+  MOCKFUNC(IsTrackSelected) MOCKFUNC(CSurf_OnSendPanChange) MOCKFUNC(CSurf_OnSendVolumeChange)
+  MOCKFUNC(GetSetTrackSendInfo) MOCKFUNC(TrackFX_GetEnabled) MOCKFUNC(TrackFX_SetEnabled) MOCKFUNC(TrackFX_Show)
+  MOCKFUNC(EnumProjects) MOCKFUNC(GetSet_LoopTimeRange) MOCKFUNC(EnumProjectMarkers)
+  MOCKFUNC(TimeMap_GetTimeSigAtTime) MOCKFUNC(TimeMap2_timeToQN) MOCKFUNC(TimeMap2_QNToTime)
+  MOCKFUNC(SnapToGrid) MOCKFUNC(SetEditCurPos2) MOCKFUNC(CSurf_OnWidthChange) MOCKFUNC(GetSelectedTrack)
+  MOCKFUNC(TrackFX_SetOpen) MOCKFUNC(SetOnlyTrackSelected) MOCKFUNC(GetMasterTrack) MOCKFUNC(DeleteTrack)
+  MOCKFUNC(GetTrackState) MOCKFUNC(NamedCommandLookup) MOCKFUNC(GetTrackNumSends) MOCKFUNC(GetTrackSendName)
+  MOCKFUNC(Main_OnCommand) MOCKFUNC(GetLastTouchedTrack) MOCKFUNC(GetTrackSendUIVolPan)
+  MOCKFUNC(TrackFX_GetParameterStepSizes) MOCKFUNC(kbd_getTextFromCmd) MOCKFUNC(GetSetMediaTrackInfo_String)
+  MOCKFUNC(GetResourcePath) MOCKFUNC(TrackFX_GetFormattedParamValue) MOCKFUNC(GetTrackColor)
+  MOCKFUNC(HasExtState) MOCKFUNC(GetExtState) MOCKFUNC(SetExtState) MOCKFUNC(Undo_BeginBlock)
+  MOCKFUNC(Undo_EndBlock) MOCKFUNC(Track_GetPeakHoldDB) MOCKFUNC(GetSetObjectState) MOCKFUNC(FreeHeapPtr)
+  MOCKFUNC(TrackList_AdjustWindows)
+
+  MOCKFUNC(DB2SLIDER) MOCKFUNC(SLIDER2DB) MOCKFUNC(GetNumMIDIInputs) MOCKFUNC(GetNumMIDIOutputs)
+  MOCKFUNC(CreateMIDIInput) MOCKFUNC(CreateMIDIOutput) MOCKFUNC(GetMIDIOutputName) MOCKFUNC(GetMIDIInputName)
+  MOCKFUNC(CSurf_TrackToID) MOCKFUNC(CSurf_TrackFromID) MOCKFUNC(CSurf_NumTracks) MOCKFUNC(CSurf_SetTrackListChange)
+  MOCKFUNC(CSurf_SetSurfaceVolume) MOCKFUNC(CSurf_SetSurfacePan) MOCKFUNC(CSurf_SetSurfaceMute)
+  MOCKFUNC(CSurf_SetSurfaceSelected) MOCKFUNC(CSurf_SetSurfaceSolo) MOCKFUNC(CSurf_SetSurfaceRecArm)
+  MOCKFUNC(CSurf_GetTouchState) MOCKFUNC(CSurf_SetAutoMode) MOCKFUNC(CSurf_SetPlayState) MOCKFUNC(CSurf_SetRepeatState)
+  MOCKFUNC(CSurf_OnVolumeChange) MOCKFUNC(CSurf_OnPanChange) MOCKFUNC(CSurf_OnMuteChange)
+  MOCKFUNC(CSurf_OnSelectedChange) MOCKFUNC(CSurf_OnSoloChange) MOCKFUNC(CSurf_OnFXChange)
+  MOCKFUNC(CSurf_OnRecArmChange) MOCKFUNC(CSurf_OnPlay) MOCKFUNC(CSurf_OnStop) MOCKFUNC(CSurf_OnFwd)
+  MOCKFUNC(CSurf_OnRew) MOCKFUNC(CSurf_OnRecord) MOCKFUNC(CSurf_GoStart) MOCKFUNC(CSurf_GoEnd)
+  MOCKFUNC(CSurf_OnArrow) MOCKFUNC(CSurf_OnTrackSelection) MOCKFUNC(CSurf_ResetAllCachedVolPanStates)
+  MOCKFUNC(CSurf_ScrubAmt) MOCKFUNC(TrackList_UpdateAllExternalSurfaces) MOCKFUNC(kbd_OnMidiEvent)
+  MOCKFUNC(GetMasterMuteSoloFlags) MOCKFUNC(ClearAllRecArmed) MOCKFUNC(SetTrackAutomationMode)
+  MOCKFUNC(GetTrackAutomationMode) MOCKFUNC(SoloAllTracks) MOCKFUNC(MuteAllTracks) MOCKFUNC(BypassFxAllTracks)
+  MOCKFUNC(GetTrackInfo) MOCKFUNC(SetTrackSelected) MOCKFUNC(SetAutomationMode) MOCKFUNC(UpdateTimeline)
+  MOCKFUNC(Main_UpdateLoopInfo) MOCKFUNC(GetPlayState) MOCKFUNC(GetPlayPosition) MOCKFUNC(GetCursorPosition)
+  MOCKFUNC(format_timestr_pos) MOCKFUNC(TimeMap2_timeToBeats) MOCKFUNC(Track_GetPeakInfo)
+  MOCKFUNC(GetTrackUIVolPan) MOCKFUNC(GetSetRepeat) MOCKFUNC(mkvolpanstr) MOCKFUNC(mkvolstr) MOCKFUNC(mkpanstr)
+  MOCKFUNC(MoveEditCursor) MOCKFUNC(adjustZoom) MOCKFUNC(GetHZoomLevel)
+  MOCKFUNC(TrackFX_GetCount) MOCKFUNC(TrackFX_GetNumParams) MOCKFUNC(TrackFX_GetParam) MOCKFUNC(TrackFX_SetParam)
+  MOCKFUNC(TrackFX_GetParamName) MOCKFUNC(TrackFX_FormatParamValue) MOCKFUNC(TrackFX_GetFXName)
+  MOCKFUNC(GetTrackGUID) MOCKFUNC(get_config_var) MOCKFUNC(projectconfig_var_getoffs) MOCKFUNC(projectconfig_var_addr)
+  { NULL, NULL }
+};
+
+
+void* Mock_GetFunc(const char* name)
+{
+  for (int i = 0; g_funcs[i].name; i++)
+    if (!strcmp(g_funcs[i].name, name)) return g_funcs[i].func;
+
+  fprintf(stderr, "mock: missing API function %s\n", name);
+  return NULL;
+}
+
+
+int Mock_Register(const char* name, void* infostruct)
+{
+  if (!strcmp(name, "csurf")) g_csurf_reg = (reaper_csurf_reg_t*)infostruct;
+  return 1;
+}
+
+
+reaper_csurf_reg_t* Mock_CsurfReg() { return g_csurf_reg; }
+void Mock_SetSurface(IReaperControlSurface* surf) { g_surface = surf; }
+
+
+////// PROJECT //////
+
+void Mock_Init(const MockProjectCfg* cfg)
+{
+  Mock_Free();
+  g_cfg = *cfg;
+
+  unsigned int seed = 2400;
+
+  for (int i = 0; i <= cfg->tracks; i++)
+  {
+    MockTrack* tk = new MockTrack;
+    tk->idx = i;
+    memset(&tk->guid, 0, sizeof(GUID));
+    tk->guid.Data1 = i;
+
+    int aux = i - (cfg->tracks - cfg->aux_buses);
+    char name[64];
+    if (i == 0) sprintf(name, "MASTER");
+    else if (aux > 0) sprintf(name, "AUX---%d Bus", aux);
+    else sprintf(name, "Track #%d (%s)", i, (i % 3) ? "gtr" : "vox");
+    tk->name = name;
+
+    seed = seed * 1103515245 + 12345;
+    tk->vol = 0.25 + (double)((seed >> 8) % 1000) / 1000.0;
+    tk->pan = 0.0;
+    tk->width = 1.0;
+    tk->mute = tk->phase = tk->sel = false;
+    tk->solo = tk->recarm = 0;
+    tk->fxen = 1;
+    tk->automode = 0;
+    tk->color = (i % 4) ? 0 : (0x1000000 | (seed & 0xffffff));
+    tk->peak[0] = tk->peak[1] = 0.0;
+    tk->hold_db[0] = tk->hold_db[1] = -150.0;
+
+    if (i > 0 && aux <= 0)
+    {
+      for (int h = 0; h < cfg->hwouts; h++)
+      {
+        MockSend s = { -1, 0, 1.0, 0.0 };
+        tk->hwouts.push_back(s);
+      }
+
+      for (int s = 0; s < cfg->sends; s++)
+      {
+        MockSend snd = { 0, (s % 2) ? 3 : 0, 0.5, 0.0 };
+        if (s < cfg->aux_buses) snd.dest = cfg->tracks - cfg->aux_buses + 1 + s;
+        else snd.dest = 1 + (i + s) % (cfg->tracks - cfg->aux_buses);
+        tk->sends.push_back(snd);
+      }
+
+      for (int f = 0; f < cfg->fx; f++)
+      {
+        MockFX fx;
+        char fxname[64];
+        sprintf(fxname, "VST: ReaPlug %d (Cockos)", f + 1);
+        fx.name = fxname;
+        fx.enabled = true;
+        for (int p = 0; p < cfg->fx_params; p++) fx.params.push_back((double)((p * 37) % 100) / 100.0);
+        tk->fx.push_back(fx);
+      }
+    }
+
+    g_tracks.push_back(tk);
+  }
+
+  g_playpos = g_cursorpos = 0.0;
+  g_out_msgs = g_out_bytes = g_out_flushes = g_out_badbytes = 0;
+}
+
+
+void Mock_Free()
+{
+  for (size_t i = 0; i < g_tracks.size(); i++) delete g_tracks[i];
+  g_tracks.clear();
+  g_extstate.clear();
+}
+
+
+double Mock_VolToSlider(double vol)
+{
+  return mock_api::DB2SLIDER(VAL2DB(vol));
+}
+
+
+void Mock_SetExtState(const char* section, const char* key, const char* value)
+{
+  g_extstate[std::string(section) + "/" + key] = value;
+}
+
+
+int Mock_NumTracks() { return (int)g_tracks.size() - 1; }
+MockTrack* Mock_Track(int idx) { return (idx >= 0 && idx < (int)g_tracks.size()) ? g_tracks[idx] : NULL; }
+MediaTrack* Mock_MediaTrack(int idx) { return Mt(idx); }
+
+
+void Mock_Tick(double secs)
+{
+  g_playpos += secs;
+  US2400BenchClockTick((long)(secs * 1e6));
+
+  // deterministic "signal": every track has its own rate, some are silent
+  for (size_t i = 1; i < g_tracks.size(); i++)
+  {
+    MockTrack* tk = g_tracks[i];
+    double level = (i % 5 == 0) ? 0.0 : 0.6 + 0.45 * sin(g_playpos * (1.0 + 0.37 * i));
+    if (level < 0.0) level = 0.0;
+    tk->peak[0] = level;
+    tk->peak[1] = level * 0.9;
+
+    for (int c = 0; c < 2; c++)
+    {
+      double db = VAL2DB(tk->peak[c]);
+      if (db > tk->hold_db[c]) tk->hold_db[c] = db;
+    }
+  }
+}
+
+
+void Mock_HostSetVolume(int idx, double vol)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk) return;
+  tk->vol = vol;
+  if (g_surface) g_surface->SetSurfaceVolume((MediaTrack*)tk, vol);
+}
+
+void Mock_HostSetPan(int idx, double pan)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk) return;
+  tk->pan = pan;
+  if (g_surface) g_surface->SetSurfacePan((MediaTrack*)tk, pan);
+}
+
+void Mock_HostSetSelected(int idx, bool sel)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk) return;
+  tk->sel = sel;
+  if (g_surface) g_surface->SetSurfaceSelected((MediaTrack*)tk, sel);
+}
+
+void Mock_HostSetSolo(int idx, int solo)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk) return;
+  tk->solo = solo;
+  if (g_surface) g_surface->SetSurfaceSolo((MediaTrack*)tk, solo != 0);
+}
+
+void Mock_HostSetSendVolume(int idx, int send_idx, double vol)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk || send_idx < 0 || send_idx >= (int)tk->sends.size()) return;
+  tk->sends[send_idx].vol = vol;
+  int send_index = (int)tk->hwouts.size() + send_idx; // as GetTrackSendUIVolPan counts
+  if (g_surface) g_surface->Extended(CSURF_EXT_SETSENDVOLUME, (MediaTrack*)tk, &send_index, &vol);
+}
+
+void Mock_HostSetFXParam(int idx, int fx, int param, double val)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk || fx < 0 || fx >= (int)tk->fx.size() || param < 0 || param >= (int)tk->fx[fx].params.size()) return;
+  tk->fx[fx].params[param] = val;
+  int fxparam = (fx << 16) | param;
+  if (g_surface) g_surface->Extended(CSURF_EXT_SETFXPARAM, (MediaTrack*)tk, &fxparam, &val);
+}
+
+void Mock_HostSetTitle(int idx, const char* name)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk) return;
+  tk->name = name;
+  if (g_surface) g_surface->SetTrackTitle((MediaTrack*)tk, name);
+}
+
+void Mock_HostPollTouch(int idx)
+{
+  MockTrack* tk = Mock_Track(idx);
+  if (!tk || !g_surface) return;
+  g_surface->GetTouchState((MediaTrack*)tk, 0);
+  g_surface->GetTouchState((MediaTrack*)tk, 1);
+}
+
+
+////// MIDI IN //////
+
+void Mock_QueueMIDI(unsigned char s, unsigned char d1, unsigned char d2, unsigned char d3)
+{
+  if (!g_midiin) return;
+  MIDI_event_t evt = { 0, 3, { s, d1, d2, d3 } };
+  g_midiin->m_pending.AddItem(&evt);
+}
+
+int Mock_QueuedMIDI()
+{
+  return g_midiin ? (int)g_midiin->m_pending.m_evts.size() : 0;
+}
+
+void Mock_TakeQueuedMIDI(std::vector<MIDI_event_t>* out)
+{
+  out->clear();
+  if (g_midiin) out->swap(g_midiin->m_pending.m_evts);
+}
+
+void Mock_QueueEvent(const MIDI_event_t* evt)
+{
+  if (!g_midiin) return;
+  g_midiin->m_pending.AddItem((MIDI_event_t*)evt);
+}
+
+
+////// COUNTERS //////
+
+void Mock_ResetCounters()
+{
+  for (std::map<std::string, long>::iterator it = g_counts.begin(); it != g_counts.end(); ++it) it->second = 0;
+  g_out_msgs = g_out_bytes = g_out_flushes = g_out_badbytes = 0;
+}
+
+long Mock_TotalCalls()
+{
+  long sum = 0;
+  for (std::map<std::string, long>::iterator it = g_counts.begin(); it != g_counts.end(); ++it) sum += it->second;
+  return sum;
+}
+
+static bool Mock_CountCmp(const MockApiCount& a, const MockApiCount& b)
+{
+  return a.calls > b.calls;
+}
+
+void Mock_GetCounts(std::vector<MockApiCount>* out)
+{
+  out->clear();
+  for (std::map<std::string, long>::iterator it = g_counts.begin(); it != g_counts.end(); ++it)
+  {
+    if (it->second == 0) continue;
+    MockApiCount c = { it->first.c_str(), it->second };
+    out->push_back(c);
+  }
+  std::sort(out->begin(), out->end(), Mock_CountCmp);
+}
+
+long Mock_MIDIOutMsgs() { return g_out_msgs; }
+long Mock_MIDIOutBytes() { return g_out_bytes; }
+long Mock_MIDIOutFlushes() { return g_out_flushes; }
+long Mock_MIDIOutBadBytes() { return g_out_badbytes; }
@@ -0,0 +1,107 @@
+/*
+** US-2400 bench harness
+** In-memory mock of the REAPER host API
+**
+** Hands out function pointers by name (like reaper_plugin_info_t::GetFunc),
+** keeps a small project of N tracks with sends and FX, counts every API
+** call and records what the surface sends to its MIDI output.
+*/
+
+#ifndef _US2400_REAPER_MOCK_H_
+#define _US2400_REAPER_MOCK_H_
+
+#include "../../reaper_plugin.h"
+#include <vector>
+#include <string>
+
+
+struct MockSend
+{
+  int dest;     // track index of receiving track (-1 = hardware output)
+  int mode;     // I_SENDMODE: 0 = post, 1 = pre fx, 3 = post fx
+  double vol;
+  double pan;
+};
+
+struct MockFX
+{
+  std::string name;
+  bool enabled;
+  std::vector<double> params;
+};
+
+struct MockTrack
+{
+  int idx; // 0 = master
+  std::string name;
+  GUID guid;
+  double vol, pan, width;
+  bool mute, phase, sel;
+  int solo, recarm, fxen, automode, color;
+  double peak[2];
+  double hold_db[2];
+  std::vector<MockSend> hwouts; // GetTrackSendName & co. enumerate hardware outputs first
+  std::vector<MockSend> sends;
+  std::vector<MockFX> fx;
+};
+
+struct MockProjectCfg
+{
+  int tracks;       // regular tracks, master comes on top
+  int aux_buses;    // the last n tracks are named "AUX---n"
+  int sends;        // sends per track, to aux buses first
+  int hwouts;       // hardware outputs per track
+  int fx;           // fx per track
+  int fx_params;    // parameters per fx
+  bool notify;      // CSurf_On*Change calls back into the surface like REAPER does
+};
+
+struct MockApiCount
+{
+  const char* name;
+  long calls;
+};
+
+
+// setup / teardown
+void Mock_Init(const MockProjectCfg* cfg);
+void Mock_Free();
+void* Mock_GetFunc(const char* name);
+int Mock_Register(const char* name, void* infostruct);
+reaper_csurf_reg_t* Mock_CsurfReg();
+void Mock_SetSurface(IReaperControlSurface* surf);
+void Mock_SetExtState(const char* section, const char* key, const char* value); // not counted
+
+// project access
+int Mock_NumTracks();
+MockTrack* Mock_Track(int idx);
+MediaTrack* Mock_MediaTrack(int idx);
+void Mock_Tick(double secs); // advance play position and peaks
+double Mock_VolToSlider(double vol); // host taper, 0 - 1000
+
+// host side changes (automation playback, select all, clear solo etc.)
+void Mock_HostSetVolume(int idx, double vol);
+void Mock_HostSetPan(int idx, double pan);
+void Mock_HostSetSelected(int idx, bool sel);
+void Mock_HostSetSolo(int idx, int solo);
+void Mock_HostSetSendVolume(int idx, int send_idx, double vol);
+void Mock_HostSetFXParam(int idx, int fx, int param, double val);
+void Mock_HostSetTitle(int idx, const char* name);
+void Mock_HostPollTouch(int idx);
+
+// midi in
+void Mock_QueueMIDI(unsigned char s, unsigned char d1, unsigned char d2, unsigned char d3);
+int Mock_QueuedMIDI();
+void Mock_TakeQueuedMIDI(std::vector<MIDI_event_t>* out); // empties the queue
+void Mock_QueueEvent(const MIDI_event_t* evt);
+
+// counters
+void Mock_ResetCounters();
+long Mock_TotalCalls();
+void Mock_GetCounts(std::vector<MockApiCount>* out); // sorted by calls, descending
+long Mock_MIDIOutMsgs();
+long Mock_MIDIOutBytes();
+long Mock_MIDIOutFlushes();
+long Mock_MIDIOutBadBytes(); // data bytes with the status bit set
+
+#endif // _US2400_REAPER_MOCK_H_
@@ -0,0 +1,345 @@
+/*
+** US-2400 bench harness
+** Headless stand-in for <windows.h>
+**
+** Just enough of the Win32 API for csurf_us2400.cpp / csurf_main.cpp to
+** compile and run on Linux without a window system: types, constants,
+** no-op window/GDI calls and pthread-backed threads. The bench Makefile
+** builds with -D_WIN32 and puts this directory first on the include path.
+*/
+
+#ifndef _US2400_BENCH_WINDOWS_H_
+#define _US2400_BENCH_WINDOWS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define __declspec(x)
+#define WINAPI
+#define CALLBACK
+#define _vsnprintf vsnprintf
+#define _snprintf snprintf
+#define lstrcpyn(d, s, n) (strncpy((d), (s), (n)), (d)[(n) - 1] = 0, (d))
+
+typedef int BOOL;
+typedef unsigned char BYTE;
+typedef unsigned short WORD;
+typedef unsigned int DWORD;
+typedef unsigned int UINT;
+typedef long LONG;
+typedef intptr_t INT_PTR;
+typedef uintptr_t UINT_PTR;
+typedef intptr_t LONG_PTR;
+typedef intptr_t LPARAM;
+typedef uintptr_t WPARAM;
+typedef intptr_t LRESULT;
+typedef void* LPVOID;
+typedef const char* LPCSTR;
+typedef char* LPSTR;
+typedef DWORD COLORREF;
+
+typedef struct HWND__* HWND;
+typedef struct HDC__* HDC;
+typedef struct HINSTANCE__* HINSTANCE;
+typedef struct HGDIOBJ__* HGDIOBJ;
+typedef HGDIOBJ HFONT;
+typedef HGDIOBJ HBRUSH;
+typedef HGDIOBJ HPEN;
+typedef HGDIOBJ HICON;
+typedef HGDIOBJ HCURSOR;
+typedef HGDIOBJ HMENU;
+typedef void* HANDLE;
+
+typedef struct { LONG left, top, right, bottom; } RECT;
+typedef struct { LONG x, y; } POINT;
+typedef struct { HDC hdc; BOOL fErase; RECT rcPaint; } PAINTSTRUCT;
+typedef struct { HWND hwnd; UINT message; WPARAM wParam; LPARAM lParam; DWORD time; POINT pt; } MSG;
+typedef struct { BYTE fVirt; WORD key; WORD cmd; } ACCEL;
+typedef pthread_mutex_t CRITICAL_SECTION;
+typedef struct { unsigned int Data1; unsigned short Data2, Data3; unsigned char Data4[8]; } GUID;
+
+typedef LRESULT (*WNDPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef INT_PTR (*DLGPROC)(HWND, UINT, WPARAM, LPARAM);
+typedef DWORD (*LPTHREAD_START_ROUTINE)(LPVOID);
+
+typedef struct
+{
+  UINT cbSize;
+  UINT style;
+  WNDPROC lpfnWndProc;
+  int cbClsExtra;
+  int cbWndExtra;
+  HINSTANCE hInstance;
+  HICON hIcon;
+  HCURSOR hCursor;
+  HBRUSH hbrBackground;
+  LPCSTR lpszMenuName;
+  LPCSTR lpszClassName;
+  HICON hIconSm;
+} WNDCLASSEX;
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+#define INFINITE 0xFFFFFFFF
+
+#define RGB(r, g, b) ((COLORREF)(((BYTE)(r)) | ((WORD)((BYTE)(g)) << 8) | (((DWORD)(BYTE)(b)) << 16)))
+#define GetRValue(c) ((BYTE)(c))
+#define GetGValue(c) ((BYTE)((c) >> 8))
+#define GetBValue(c) ((BYTE)((c) >> 16))
+#define MAKEINTRESOURCE(i) ((LPSTR)(UINT_PTR)(i))
+
+#define WM_PAINT 0x000F
+#define WM_SIZE 0x0005
+#define WM_MOVE 0x0003
+#define WM_INITDIALOG 0x0110
+#define WM_USER 0x0400
+
+#define WS_POPUP 0x80000000L
+#define WS_BORDER 0x00800000L
+#define WS_THICKFRAME 0x00040000L
+#define WS_EX_TOPMOST 0x00000008L
+#define WS_EX_TRANSPARENT 0x00000020L
+#define WS_EX_TOOLWINDOW 0x00000080L
+#define WS_EX_LAYERED 0x00080000L
+#define WS_EX_NOACTIVATE 0x08000000L
+
+#define SW_HIDE 0
+#define SW_SHOW 5
+#define SPI_GETWORKAREA 0x0030
+#define LWA_ALPHA 0x00000002
+#define ULW_COLORKEY 0x00000001
+#define PS_SOLID 0
+#define TRANSPARENT 1
+#define DEFAULT_GUI_FONT 17
+#define IDI_APPLICATION MAKEINTRESOURCE(32512)
+#define IDC_ARROW MAKEINTRESOURCE(32512)
+
+#define DT_CENTER 0x00000001
+#define DT_VCENTER 0x00000004
+#define DT_SINGLELINE 0x00000020
+#define DT_WORDBREAK 0x00000010
+#define DT_END_ELLIPSIS 0x00008000
+#define DT_WORD_ELLIPSIS 0x00040000
+
+#define CB_ERR (-1)
+#define CB_ADDSTRING 0x0143
+#define CB_GETCURSEL 0x0147
+#define CB_SETCURSEL 0x014E
+#define CB_GETITEMDATA 0x0150
+#define CB_SETITEMDATA 0x0151
+
+#define BST_UNCHECKED 0x0000
+#define BST_CHECKED 0x0001
+
+
+// windows: a non-null dummy handle, nothing is ever drawn
+
+inline HWND CreateWindowEx(DWORD, LPCSTR, LPCSTR, DWORD, int, int, int, int, HWND, HMENU, HINSTANCE, LPVOID) { return (HWND)(INT_PTR)0x2400; }
+inline BOOL DestroyWindow(HWND) { return TRUE; }
+inline BOOL ShowWindow(HWND, int) { return TRUE; }
+inline BOOL UpdateWindow(HWND) { return TRUE; }
+inline BOOL InvalidateRect(HWND, const RECT*, BOOL) { return TRUE; }
+inline BOOL GetWindowRect(HWND, RECT* r) { r->left = r->top = 0; r->right = 1920; r->bottom = 80; return TRUE; }
+inline LRESULT DefWindowProc(HWND, UINT, WPARAM, LPARAM) { return 0; }
+inline unsigned short RegisterClassEx(const WNDCLASSEX*) { return 1; }
+inline HICON LoadIcon(HINSTANCE, LPCSTR) { return 0; }
+inline HCURSOR LoadCursor(HINSTANCE, LPCSTR) { return 0; }
+inline BOOL SetLayeredWindowAttributes(HWND, COLORREF, BYTE, DWORD) { return TRUE; }
+inline BOOL UpdateLayeredWindow(HWND, HDC, POINT*, void*, HDC, POINT*, COLORREF, void*, DWORD) { return TRUE; }
+inline BOOL SystemParametersInfo(UINT, UINT, void* p, UINT) { RECT* r = (RECT*)p; r->left = r->top = 0; r->right = 1920; r->bottom = 1080; return TRUE; }
+inline HWND GetDlgItem(HWND, int) { return 0; }
+inline LRESULT SendDlgItemMessage(HWND, int, UINT, WPARAM, LPARAM) { return CB_ERR; }
+inline BOOL CheckDlgButton(HWND, int, UINT) { return TRUE; }
+inline UINT IsDlgButtonChecked(HWND, int) { return BST_UNCHECKED; }
+inline HWND CreateDialogParam(HINSTANCE, LPCSTR, HWND, DLGPROC, LPARAM) { return 0; }
+
+// gdi: no-ops
+
+inline HDC BeginPaint(HWND, PAINTSTRUCT* ps) { memset(ps, 0, sizeof(*ps)); return 0; }
+inline BOOL EndPaint(HWND, const PAINTSTRUCT*) { return TRUE; }
+inline HGDIOBJ GetStockObject(int) { return 0; }
+inline HGDIOBJ SelectObject(HDC, HGDIOBJ) { return 0; }
+inline BOOL DeleteObject(HGDIOBJ) { return TRUE; }
+inline HBRUSH CreateSolidBrush(COLORREF) { return 0; }
+inline HPEN CreatePen(int, int, COLORREF) { return 0; }
+inline int FillRect(HDC, const RECT*, HBRUSH) { return 1; }
+inline int DrawText(HDC, LPCSTR, int, RECT*, UINT) { return 0; }
+inline COLORREF SetTextColor(HDC, COLORREF) { return 0; }
+inline COLORREF SetBkColor(HDC, COLORREF) { return 0; }
+inline int SetBkMode(HDC, int) { return 0; }
+inline BOOL MoveToEx(HDC, int, int, POINT*) { return TRUE; }
+inline BOOL LineTo(HDC, int, int) { return TRUE; }
+
+// time / threads
+
+// Once Mock_Tick() runs, the clock goes in cycle time (Sleep() moves it on too),
+// so the surface sees 30 Hz however fast the bench calls Run()
+struct US2400BenchClock
+{
+  bool on;
+  volatile long us;
+};
+
+inline US2400BenchClock& US2400BenchClockState()
+{
+  static US2400BenchClock clock = { false, 0 };
+  return clock;
+}
+
+inline long US2400BenchRealTime()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000; // us
+}
+
+inline void US2400BenchClockTick(long us)
+{
+  US2400BenchClock& clock = US2400BenchClockState();
+  if (!clock.on)
+  {
+    clock.us = US2400BenchRealTime();
+    clock.on = true;
+  }
+  __sync_fetch_and_add(&clock.us, us);
+}
+
+inline DWORD timeGetTime()
+{
+  US2400BenchClock& clock = US2400BenchClockState();
+  return (DWORD)((clock.on ? clock.us : US2400BenchRealTime()) / 1000);
+}
+
+inline DWORD GetTickCount() { return timeGetTime(); }
+
+inline void Sleep(DWORD ms)
+{
+  usleep(ms * 1000);
+  if (US2400BenchClockState().on) __sync_fetch_and_add(&US2400BenchClockState().us, (long)ms * 1000);
+}
+
+// threads and (auto-reset) events share HANDLE, the first member tells them apart
+struct US2400BenchHandle
+{
+  bool event;
+};
+
+struct US2400BenchThread : US2400BenchHandle
+{
+  pthread_t th;
+  LPTHREAD_START_ROUTINE proc;
+  LPVOID parm;
+};
+
+struct US2400BenchEvent : US2400BenchHandle
+{
+  pthread_mutex_t mtx;
+  pthread_cond_t cond;
+  bool set;
+};
+
+#define WAIT_OBJECT_0 0
+#define WAIT_TIMEOUT 0x102
+
+inline void* US2400BenchThreadProc(void* p)
+{
+  US2400BenchThread* t = (US2400BenchThread*)p;
+  t->proc(t->parm);
+  return NULL;
+}
+
+inline HANDLE CreateThread(void*, size_t, LPTHREAD_START_ROUTINE proc, LPVOID parm, DWORD, DWORD* id)
+{
+  US2400BenchThread* t = new US2400BenchThread;
+  t->event = false;
+  t->proc = proc;
+  t->parm = parm;
+  if (pthread_create(&t->th, NULL, US2400BenchThreadProc, t) != 0) { delete t; return NULL; }
+  if (id) *id = 0;
+  return (HANDLE)(US2400BenchHandle*)t;
+}
+
+inline HANDLE CreateEvent(void*, BOOL, BOOL initial, LPCSTR) // auto-reset only
+{
+  US2400BenchEvent* e = new US2400BenchEvent;
+  e->event = true;
+  pthread_mutex_init(&e->mtx, NULL);
+  pthread_cond_init(&e->cond, NULL);
+  e->set = (initial != 0);
+  return (HANDLE)(US2400BenchHandle*)e;
+}
+
+inline BOOL SetEvent(HANDLE h)
+{
+  US2400BenchEvent* e = (US2400BenchEvent*)(US2400BenchHandle*)h;
+  pthread_mutex_lock(&e->mtx);
+  e->set = true;
+  pthread_cond_signal(&e->cond);
+  pthread_mutex_unlock(&e->mtx);
+  return TRUE;
+}
+
+inline DWORD WaitForSingleObject(HANDLE h, DWORD ms)
+{
+  US2400BenchHandle* hd = (US2400BenchHandle*)h;
+  if (!hd) return WAIT_OBJECT_0;
+
+  if (!hd->event)
+  {
+    pthread_join(((US2400BenchThread*)hd)->th, NULL);
+    return WAIT_OBJECT_0;
+  }
+
+  // events wait in real time, the cycle clock doesn't move
+  US2400BenchEvent* e = (US2400BenchEvent*)hd;
+  struct timespec until;
+  clock_gettime(CLOCK_REALTIME, &until);
+  until.tv_sec += ms / 1000;
+  until.tv_nsec += (long)(ms % 1000) * 1000000;
+  if (until.tv_nsec >= 1000000000) { until.tv_sec++; until.tv_nsec -= 1000000000; }
+
+  pthread_mutex_lock(&e->mtx);
+  while (!e->set)
+  {
+    if (ms == INFINITE) pthread_cond_wait(&e->cond, &e->mtx);
+    else if (pthread_cond_timedwait(&e->cond, &e->mtx, &until) != 0) break;
+  }
+  DWORD res = e->set ? WAIT_OBJECT_0 : WAIT_TIMEOUT;
+  e->set = false;
+  pthread_mutex_unlock(&e->mtx);
+  return res;
+}
+
+inline BOOL CloseHandle(HANDLE h)
+{
+  US2400BenchHandle* hd = (US2400BenchHandle*)h;
+  if (hd && hd->event)
+  {
+    US2400BenchEvent* e = (US2400BenchEvent*)hd;
+    pthread_cond_destroy(&e->cond);
+    pthread_mutex_destroy(&e->mtx);
+    delete e;
+  }
+  else delete (US2400BenchThread*)hd;
+  return TRUE;
+}
+
+inline BOOL SetThreadPriority(HANDLE, int) { return TRUE; }
+inline HANDLE GetCurrentThread() { return 0; }
+#define THREAD_PRIORITY_ABOVE_NORMAL 1
+#define THREAD_PRIORITY_HIGHEST 2
+
+inline LONG InterlockedExchange(volatile LONG* t, LONG v) { return __sync_lock_test_and_set(t, v); }
+inline LONG InterlockedIncrement(volatile LONG* t) { return __sync_add_and_fetch(t, 1); }
+inline LONG InterlockedDecrement(volatile LONG* t) { return __sync_sub_and_fetch(t, 1); }
+inline LONG InterlockedCompareExchange(volatile LONG* t, LONG v, LONG cmp) { return __sync_val_compare_and_swap(t, cmp, v); }
+
+#endif // _US2400_BENCH_WINDOWS_H_
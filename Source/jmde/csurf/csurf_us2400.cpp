@@ -8,9 +8,9 @@
 
 ////// PREFERENCES //////
 
-// Meter enabled
-#define METERMODE true // false // 
-#define DESCSTRING "Tascam US-2400 (with VU-Meters)" // "Tascam US-2400 (M-Key Support)" // 
+// Meter mode (rings as VU-Meters) or M-Key mode (Meter button as qualifier)
+// is set in the preferences dialog, Shift + Meter switches on the fly
+#define DESCSTRING "Tascam US-2400"
 
 // Meter: -inf = x dB
 #define MINUSINF -90.0
@@ -27,6 +27,17 @@
 #define ENCRESFX 300
 #define ENCRESFXFINE 3000
 #define ENCRESFXTOGGLE 1
+// Fader lsb not completed by its msb within x ms is dropped
+#define FDRLSBTIMEOUT 100
+
+// Encoder / wheel acceleration: above ENCACCELMIN ticks per second the step
+// grows with turning speed, up to ENCACCELMAX times the resolutions above / below.
+// Speed is measured per run cycle (appr. 30 Hz): one tick per cycle is already
+// 30 ticks/s, so keep this well above, a single tick never accelerates
+#define ENCACCELMIN 100
+#define ENCACCELMAX 4.0
+// Turns further apart than this (ms) count as a new, slow movement
+#define ENCACCELGAP 250
 // How long will encoders be considered touch, in run circles (15 Hz -> 3 circles = 200ms)
 #define ENCTCHDLY 10
 
@@ -43,8 +54,46 @@
 #define MYBLINKINTV 20
 #define MYBLINKRATIO 1
 
-// Execute only X Faders/Encoders at a time
-#define EXLIMIT 10
+// Re-read states REAPER doesn't report (phase, track fx enable, send count)
+// every X cycles (1 = appr. 30 Hz / 0.03 s)
+#define MYPOLLINTV 20
+
+// Meter frame every X ms, independent of REAPER's csurfrate
+#define METERINTV 33
+
+// Sample meters on an own thread at X Hz, frames take the maximum in between
+// (csurf_us2400_meters.h, 0 = read in the frame)
+#ifndef METERSAMPLE
+#define METERSAMPLE 0
+#endif
+
+// Meter ballistics: peak release in dB/s, VU integration in ms (0 = peak meter),
+// hold and over led in ms (0 = until the meter button)
+#define METERRELEASE 24
+#define METERVU 0
+#define METERHOLD 2000
+#define METEROVER 2000
+
+// Slots of the MediaTrack* -> channel hash (power of 2, > 25)
+#define BANKHASHSIZE 64
+
+// Fader / encoder / meter updates: sent within OUTRATE, at most X ms
+// worth at once; an update moves up one priority every X cycles it waits
+#define SCHEDBURST 50
+#define SCHEDAGE 4
+
+// MIDI out: messages per frame (flushed once per Run) and
+// running status packing (0 = one Send() per message)
+#define OUTFRAMESIZE 256
+#define OUTFRAMEPACK 1
+
+// MIDI out thread (csurf_us2400_outqueue.h): feeds the surface at most X bytes/s
+// (0 = unpaced), newer fader / encoder / ring values replace queued ones
+// (OUTQUEUE 0 = REAPER's threaded output); updates are scheduled to fit
+#ifndef OUTQUEUE
+#define OUTQUEUE 1
+#endif
+#define OUTRATE 6250
 
 // For finding sends see MyCSurf_Aux_Send)
 #define AUXSTRING "aux---%d"
@@ -79,8 +128,18 @@
 #define CMD_SEL2LASTTOUCH 40914
 
 #include "csurf.h"
+#include "csurf_us2400_protocol.h"
+#include "csurf_us2400_taper.h"
+#include "csurf_us2400_outqueue.h"
+#include "csurf_us2400_meters.h"
+#include "csurf_us2400_framebuffer.h"
 #include <map>
 
+// volume taper tables, see csurf_us2400_taper.h
+double tpr_gain[TPR_SIZE];
+float tpr_level_scale, tpr_level_offset;
+bool tpr_ready = false;
+
 // for debug  
 char debug[64];
 
@@ -107,7 +166,7 @@ int stp_x = -1;
 int stp_y = -1;
 int stp_open = 0;
 
-WDL_String stp_strings[49];
+WDL_String stp_strings[50]; // 0-23 numbers / values, 24-47 names, 49 fx name
 int stp_colors[24];
 unsigned long stp_enc_touch = 0;
 unsigned long stp_enc_touch_prev = 0;
@@ -151,7 +210,7 @@ void Stp_Paint(HWND hwnd)
 
   double x = 0;
   
-  for (char ch = 0; ch < 24; ch++)
+  for (int ch = 0; ch < 24; ch++)
   {
     // draw separators
     if ((ch % 8 == 0) && (ch != 0))
@@ -349,6 +408,7 @@ WDL_String hlp_inout_str[2][4]; // in/out | _/sh/f/m
 int hlp_mode = 0;
 int hlp_qkey = 0;
 bool hlp_flip = false;
+bool hlp_meter = true;
 
 int hlp_open = 0;
 
@@ -542,7 +602,7 @@ void Hlp_Paint(HWND hwnd)
 
   Hlp_DrawBox("Null",           hlp_margin + 1*hlp_sep + 3*hlp_grid, hlp_margin + 2*hlp_sep + 6*hlp_grid, bg_col, mode_col, qkey_col, hlp_keys_str[6][hlp_mode][hlp_qkey], &hdc);
 
-  if (!METERMODE) 
+  if (!hlp_meter)
     Hlp_DrawBox("(Meter)",      hlp_margin + 1*hlp_sep + 1*hlp_grid, hlp_margin + 2*hlp_sep + 7*hlp_grid, mkey_col, bg_col, qkey_col, WDL_String("M-Key"), &hdc);
   
   Hlp_DrawBox("F-Key",          hlp_margin + 1*hlp_sep + 2*hlp_grid, hlp_margin + 2*hlp_sep + 7*hlp_grid, fkey_col, bg_col, qkey_col, hlp_fkey_str[hlp_qkey], &hdc);
@@ -582,6 +642,36 @@ LRESULT CALLBACK Hlp_WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lPar
 }
 
 
+// CHANNEL STATE
+
+// what the surface shows of a track, read in one pass per Run()
+// (see Utl_PollChannels), padded to a cache line's size per strip
+// (not aligned: the csurf comes from plain new, no over-aligned new in C++14)
+struct ChannelState
+{
+  MediaTrack* tk; // NULL = no track
+  int tk_num; // IP_TRACKNUMBER, strip display only
+  int color; // strip display only
+  bool sel, solo, mute, fxen, phase, recarm;
+  char pad[64 - sizeof(MediaTrack*) - 2 * sizeof(int) - 6];
+};
+static_assert(sizeof(ChannelState) == 64, "ChannelState: one cache line's size");
+
+
+// METER STATE
+
+// ballistics of a channel's meter (see Utl_MeterBallistics),
+// levels in 1/256 meter steps
+struct MeterState
+{
+  int peak; // falls METERRELEASE
+  int vu; // integrates over METERVU
+  int hold;
+  DWORD hold_time, over_time;
+  bool over;
+};
+
+
 // CSURF CLASS
 
 class CSurf_US2400 : public IReaperControlSurface
@@ -599,13 +689,36 @@ class CSurf_US2400 : public IReaperControlSurface
   // cmd_ids
   int cmd_ids[4][3][12]; //[none/shift/fkey/mkey][pan/chan/aux][1-6/null/rew/ffwd/stop/play/rec]
 
-  // buffer for fader data
-  bool waitformsb;
-  unsigned char lsb;
+  // buffer for fader data: lsb per fader, waiting for its msb
+  unsigned char s_fdr_lsb[25];
+  DWORD s_fdr_lsb_time[25];
+  unsigned long s_fdr_lsb_mask;
+
+  // fader moves of one Run() cycle, latest value per fader
+  int s_fdr_pending[25];
+  unsigned long s_fdr_pending_mask;
+
+  // encoder / jog ticks of one Run() cycle, summed up
+  int s_enc_pending[24];
+  unsigned long s_enc_pending_mask;
+  int s_jog_pending;
+  DWORD s_enc_last[24]; // time of last movement, for acceleration
+  DWORD s_jog_last;
+  DWORD s_run_time;
+
+  // midi output frame, see MIDIOut_Flush
+  unsigned char s_out_frame[OUTFRAMESIZE][3];
+  short s_out_keys[OUTFRAMESIZE];
+  int s_out_len;
+  short s_out_slots[448]; // key -> frame position, -1 = not in frame
+  long s_out_msgs, s_out_dropped, s_out_bytes; // totals
 
   // for myblink
-  bool s_myblink;  
+  bool s_myblink;
   int myblink_ctr;
+  unsigned long s_blink_dots; // encoder dots that blink
+  unsigned long s_blink_btns[4]; // lit buttons that blink, off ones blink in hardware
+  int s_poll_ctr;
 
   // for init
   bool s_initdone;
@@ -615,21 +728,57 @@ class CSurf_US2400 : public IReaperControlSurface
   unsigned long s_touch_fdr;
   int s_touch_enc[24];
 
-  // caches
-  int cache_faders[25];
-  int cache_enc[24];
-  int cache_meters[24];
-  unsigned long cache_upd_faders;
-  unsigned long cache_upd_enc;
-  unsigned long cache_upd_meters;
-  char cache_exec;
-  bool master_sel;
+  // leds, faders, encoders, meters: wanted / sent, see MySetSurface_FlushFrame
+  Fb_Frame s_fb;
 
-  // button states
-  std::map<char, bool[2]> button_states;
+  DWORD s_meter_last; // last meter frame
+  DWORD s_meter_next; // when the next one is due
+  MeterState s_meters[24];
+  Mtr_Sampler* s_sampler; // NULL = no sampling thread
+
+  // scheduler, see MySetSurface_FlushFrame
+  long s_sched_tokens; // bytes * 1000
+  DWORD s_sched_last;
+  unsigned long s_sched_moved; // faders just let go: motor first
+  unsigned char s_sched_age[3][25]; // cycles waiting: fader, encoder, meter
+  char s_sched_next; // round robin
+  bool master_sel;
 
   // general states
   int s_ch_offset; // bank up/down
+
+  // tracks of current bank (0-23) and master (24), see Utl_UpdateBankCache
+  MediaTrack* s_bank_tks[25];
+  ReaProject* s_bank_project;
+
+  // and back: open addressing hash, empty slots are NULL
+  MediaTrack* s_bank_hash_tks[BANKHASHSIZE];
+  char s_bank_hash_chs[BANKHASHSIZE];
+
+  // send index and pre/post of aux 1-6 for each channel, see Utl_IndexAuxSends
+  int s_aux_sends[25][6];
+  bool s_aux_pre[25][6];
+  MediaTrack* s_aux_dest[25][6]; // receiving track, see Utl_CheckAuxSends
+  int s_aux_count[25]; // sends + hardware outputs when indexed
+  unsigned long s_aux_indexed; // channels with valid entries
+
+  // aux buses by number, see Utl_IndexAuxBuses
+  MediaTrack* s_aux_buses[7]; // 1-6, 0 unused
+  bool s_aux_buses_valid;
+
+  // track states, 0-23 and master (24), see Utl_PollChannels
+  ChannelState s_chs[25];
+  unsigned long s_chs_poll; // channels to read on next pass
+
+  // channels to refresh once per Run(), flagged by REAPER's callbacks
+  // and Utl_PollChannels, see Utl_UpdateChannels
+  unsigned long s_upd_fdr, s_upd_enc, s_upd_elem, s_upd_stp;
+  bool s_upd_clrsolo;
+
+  // track names for the strip, alphanumeric, see Utl_StoreTrackName
+  WDL_String s_names[24];
+  unsigned long s_names_valid; // channels with valid entries
+
   bool s_play, s_rec, s_loop; // play states
   char s_automode; // automation modes
 
@@ -637,6 +786,14 @@ class CSurf_US2400 : public IReaperControlSurface
   bool m_flip, m_chan, m_pan, m_scrub;
   char m_aux;
 
+  // meter mode, else m-key; the hot paths are instantiated
+  // per mode and picked here, see Utl_SelectMeterMode
+  bool m_meter;
+  void (CSurf_US2400::*p_update_enc)(int ch_id);
+  void (CSurf_US2400::*p_on_meter)();
+  void (CSurf_US2400::*p_run)();
+  bool m_meter_toggle; // shift + meter, switched before the next Run<meter>
+
   // qualifier keys
   bool q_fkey, q_shift, q_mkey;
   int s_mkey_on;
@@ -648,6 +805,8 @@ class CSurf_US2400 : public IReaperControlSurface
   int chan_fx_count;
   int chan_par_offs;
   bool chan_fx_env_arm;
+  bool chan_fx_changed; // fx added, deleted or moved, see Extended
+  int chan_fx_opened; // opened in REAPER, -1 = none
 
   // save track sel
   MediaTrack** saved_sel;
@@ -672,123 +831,234 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void MIDIin(MIDI_event_t *evt)
   {
-    unsigned char ch_id;
-    
+    const Prt_Decoded& ctl = Prt_Decode(evt->midi_message[0], evt->midi_message[1]);
+    unsigned char ch_id = ctl.ch;
+
     bool btn_state = false;
     if (evt->midi_message[2] == 0x7f) btn_state = true;
 
-    // msb of fader move?
-
-    if ( (waitformsb) && (evt->midi_message[0] == 0xb0) && (evt->midi_message[1] < 0x19) ) {
+    // calculate relative value for encoders and jog wheel
+    signed char rel_value;
+    if (evt->midi_message[2] < 0x40) rel_value = evt->midi_message[2];
+    else rel_value = 0x40 - evt->midi_message[2];
 
-      ch_id = evt->midi_message[1];
-      int value = (evt->midi_message[2] << 7) | lsb;
+    // buttons may depend on / change the state the coalesced moves
+    // are applied with (qualifiers, touch, modes): apply them first
+    if (evt->midi_message[0] != 0xb0) MIDIin_Flush();
 
-      OnFaderChange(ch_id, value);
+    switch (ctl.handler)
+    {
+      // fader (track and master): catch lsb, then msb
+      case PRT_FDRLSB :
+      {
+        s_fdr_lsb[ch_id] = evt->midi_message[3];
+        s_fdr_lsb_time[ch_id] = s_run_time;
+        s_fdr_lsb_mask = s_fdr_lsb_mask | (1 << ch_id);
+        break;
+      }
+      case PRT_FDRMSB :
+      {
+        // only with a fresh lsb of the same fader, otherwise drop it
+        if ((s_fdr_lsb_mask & (1 << ch_id)) > 0)
+        {
+          s_fdr_lsb_mask = s_fdr_lsb_mask & (~(1 << ch_id));
 
-      waitformsb = false;
+          if (s_run_time - s_fdr_lsb_time[ch_id] <= FDRLSBTIMEOUT)
+          {
+            int value = (evt->midi_message[2] << 7) | s_fdr_lsb[ch_id];
 
-    } else {
+            // keep only the latest value, see MIDIin_Flush
+            s_fdr_pending[ch_id] = value;
+            s_fdr_pending_mask = s_fdr_pending_mask | (1 << ch_id);
+          }
+        }
+        break;
+      }
 
-      // buttons / track elements
-      if (evt->midi_message[0] == 0xb1)
+      // encoders / jog wheel: sum up, see MIDIin_Flush
+      case PRT_ENC :
       {
-        // master buttons
-        switch (evt->midi_message[1])
-        {
-          case 0x61 : if (btn_state) OnMasterSel(); break;
-          case 0x62 : OnClrSolo(btn_state); break;
-          case 0x63 : if (btn_state) OnFlip(); break;
-          case 0x64 : if (btn_state) OnChan(); break;
-          case 0x6b : OnMeter(); break;
-          case 0x6c : if (btn_state) OnPan(); break;
-          case 0x6d : OnFKey(btn_state); break;
-          case 0x65 : if (btn_state) OnAux(1); break;
-          case 0x66 : if (btn_state) OnAux(2); break;
-          case 0x67 : if (btn_state) OnAux(3); break;
-          case 0x68 : if (btn_state) OnAux(4); break;
-          case 0x69 : if (btn_state) OnAux(5); break;
-          case 0x6a : if (btn_state) OnAux(6); break;
-          case 0x6e : OnNull(btn_state); break;
-          case 0x6f : if (btn_state) OnScrub(); break;
-          case 0x70 : OnBank(-1, btn_state); break;
-          case 0x71 : OnBank(1, btn_state); break;
-          case 0x72 : OnIn(btn_state); break;
-          case 0x73 : OnOut(btn_state); break;
-          case 0x74 : OnShift(btn_state); break;
-          case 0x75 : if (btn_state) OnRew(); break;
-          case 0x76 : if (btn_state) OnFwd(); break;
-          case 0x77 : if (btn_state) OnStop(); break;
-          case 0x78 : if (btn_state) OnPlay(); break;
-          case 0x79 : if (btn_state) OnRec(); break;
-          default :
-          {
-            // track elements
-            if (evt->midi_message[1] < 0x60)
-            {
-              ch_id = evt->midi_message[1] / 4; // floor
+        s_enc_pending[ch_id] += rel_value;
+        s_enc_pending_mask = s_enc_pending_mask | (1 << ch_id);
+        break;
+      }
+      case PRT_JOG : s_jog_pending += rel_value; break;
+
+      // track elements
+      case PRT_TOUCH : OnFaderTouch(ch_id, btn_state); break;
+      case PRT_SEL : if (btn_state) OnTrackSel(ch_id); break;
+      case PRT_SOLO : if (btn_state) OnTrackSolo(ch_id); break;
+      case PRT_MUTE : if (btn_state) OnTrackMute(ch_id); break;
+
+      // master buttons
+      case PRT_MASTERSEL : if (btn_state) OnMasterSel(); break;
+      case PRT_CLRSOLO : OnClrSolo(btn_state); break;
+      case PRT_FLIP : if (btn_state) OnFlip(); break;
+      case PRT_CHAN : if (btn_state) OnChan(); break;
+      case PRT_METER : OnMeter(); break;
+      case PRT_PAN : if (btn_state) OnPan(); break;
+      case PRT_FKEY : OnFKey(btn_state); break;
+      case PRT_AUX : if (btn_state) OnAux(ch_id); break;
+      case PRT_NULL : OnNull(btn_state); break;
+      case PRT_SCRUB : if (btn_state) OnScrub(); break;
+      case PRT_BANKDOWN : OnBank(-1, btn_state); break;
+      case PRT_BANKUP : OnBank(1, btn_state); break;
+      case PRT_IN : OnIn(btn_state); break;
+      case PRT_OUT : OnOut(btn_state); break;
+      case PRT_SHIFT : OnShift(btn_state); break;
+      case PRT_REW : if (btn_state) OnRew(); break;
+      case PRT_FWD : if (btn_state) OnFwd(); break;
+      case PRT_STOP : if (btn_state) OnStop(); break;
+      case PRT_PLAY : if (btn_state) OnPlay(); break;
+      case PRT_REC : if (btn_state) OnRec(); break;
+
+      // touch master fader
+      case PRT_MASTERTOUCH : OnFaderTouch(24, btn_state); break;
+
+      // joystick: send on to input + 1 (Tascam[2])
+      case PRT_JOYSTICK : kbd_OnMidiEvent(evt, m_midi_in_dev + 1); break;
+    } // switch (ctl.handler)
+  } // MIDIin()
 
-              char ch_element;
-              ch_element = evt->midi_message[1] % 4;    // modulo
 
-              switch (ch_element)
-              {
-                case 0 : OnFaderTouch(ch_id, btn_state); break;
-                case 1 : if (btn_state) OnTrackSel(ch_id); break;
-                case 2 : if (btn_state) OnTrackSolo(ch_id); break;
-                case 3 : if (btn_state) OnTrackMute(ch_id); break;
-              } // switch (ch_element)
-            } // if (evt->midi_message[1] < 0x60)
-          } // default
-        } // switch (evt->midi_message[1])
-
-        // encoders, fader values, jog wheel
-      } else if (evt->midi_message[0] == 0xb0) 
+  void MIDIin_Flush()
+  {
+    // one host change per control and cycle, however many moves came in
+    for (int ch = 0; ch < 25; ch++)
+    {
+      if ((s_fdr_pending_mask & (1 << ch)) > 0)
       {
-        // calculate relative value for encoders and jog wheel
-        signed char rel_value;
-        if (evt->midi_message[2] < 0x40) rel_value = evt->midi_message[2];
-        else rel_value = 0x40 - evt->midi_message[2];
+        s_fdr_pending_mask = s_fdr_pending_mask & (~(1 << ch));
+        OnFaderChange(ch, s_fdr_pending[ch]);
+      }
+    }
 
-        // fader (track and master): catch lsb - msb see above
-        if ( (evt->midi_message[1] >= 0x20) && (evt->midi_message[1] <= 0x38) )
-        {
-          lsb = evt->midi_message[3];
-          waitformsb = true;
+    for (int ch = 0; ch < 24; ch++)
+    {
+      if ((s_enc_pending_mask & (1 << ch)) > 0)
+      {
+        s_enc_pending_mask = s_enc_pending_mask & (~(1 << ch));
+        int ticks = s_enc_pending[ch];
+        s_enc_pending[ch] = 0;
 
-          // jog wheel
-        } else if (evt->midi_message[1] == 0x3C) 
-        {
+        // turned back and forth within one cycle
+        if (ticks != 0) OnEncoderChange(ch, Utl_Accelerate(ticks, &s_enc_last[ch]));
+      }
+    }
+
+    if (s_jog_pending != 0)
+    {
+      int ticks = s_jog_pending;
+      s_jog_pending = 0;
+      OnJogWheel(Utl_Accelerate(ticks, &s_jog_last));
+    }
+  } // MIDIin_Flush()
 
-          OnJogWheel(rel_value);
 
-          // encoders
-        } else if ( (evt->midi_message[1] >= 0x40) && (evt->midi_message[1] <= 0x58) ) 
-        {
-          ch_id = evt->midi_message[1] - 0x40;
+  void MIDIOut(unsigned char s, unsigned char d1, unsigned char d2)
+  {
+    // collect for this cycle's frame, a newer message
+    // for the same control replaces the queued one
+    int key = MIDIOut_Key(s, d1, d2);
+    s_out_msgs++;
 
-          OnEncoderChange(ch_id, rel_value);
-        }
+    if ( (key >= 0) && (s_out_slots[key] >= 0) )
+    {
+      s_out_frame[s_out_slots[key]][2] = d2;
+      s_out_dropped++;
+      return;
+    }
+
+    if (s_out_len >= OUTFRAMESIZE) MIDIOut_Flush();
+
+    s_out_frame[s_out_len][0] = s;
+    s_out_frame[s_out_len][1] = d1;
+    s_out_frame[s_out_len][2] = d2;
+    s_out_keys[s_out_len] = key;
+    if (key >= 0) s_out_slots[key] = s_out_len;
+    s_out_len++;
+  } // void MIDIOut(char s, char d1, char d2)
+
+
+  int MIDIOut_Key(unsigned char s, unsigned char d1, unsigned char d2)
+  {
+    // messages with the same key supersede each other, -1 = never
+    if (s == 0xb1) return d1 & 0x7f; // buttons
+    if (s != 0xb0) return -1;
 
-        // touch master fader
-      } else if (evt->midi_message[0] == 0xb2) 
+    // meters / rings: the value's high nibble selects what is set (level, hold ...),
+    // level 0x4X and level + over 0x6X set the same display
+    if ( (d1 >= Prt_Out<PRT_RING>::CC(0)) && (d1 <= Prt_Out<PRT_RING>::CC(23)) )
+    {
+      int set = (d2 >> 4) & 0x07;
+      if (set == 0x06) set = 0x04;
+      return 256 + (d1 - Prt_Out<PRT_RING>::CC(0)) * 8 + set;
+    }
+
+    return 128 + (d1 & 0x7f); // faders, encoders, bank leds
+  } // MIDIOut_Key
+
+
+  int MIDIOut_Flush()
+  {
+    // send the frame in one go, returns bytes sent
+    if (s_out_len == 0) return 0;
+
+    int bytes = 0;
+
+    if (m_midiout)
+    {
+#if OUTFRAMEPACK
+      // running status: repeated status bytes are left out
+      struct
       {
-        OnFaderTouch(24, btn_state);
+        MIDI_event_t evt;
+        unsigned char more[OUTFRAMESIZE * 3];
+      } block;
+
+      unsigned char* out = block.evt.midi_message;
+      unsigned char status = 0;
 
-        // joystick
-      } else if (evt->midi_message[0] == 0xbe) 
+      for (int i = 0; i < s_out_len; i++)
       {
-        // send on to input + 1 (Tascam[2])
-        kbd_OnMidiEvent(evt, m_midi_in_dev + 1);
-      } // (evt->midi_message[0] == 0xb1), else, else ...
-    } // if ( (waitformsb) && (evt->midi_message[0] == 0xb0) && (evt->midi_message[1] < 0x19), else
-  } // MIDIin()
+        if (s_out_frame[i][0] != status)
+        {
+          status = s_out_frame[i][0];
+          out[bytes++] = status;
+        }
+        out[bytes++] = s_out_frame[i][1];
+        out[bytes++] = s_out_frame[i][2];
+      }
+
+      block.evt.frame_offset = 0;
+      block.evt.size = bytes;
+      m_midiout->SendMsg(&block.evt, 0);
+#else
+      for (int i = 0; i < s_out_len; i++)
+        m_midiout->Send(s_out_frame[i][0], s_out_frame[i][1], s_out_frame[i][2], 0);
+
+      bytes = s_out_len * 3;
+#endif
+    }
+
+    // clear
+    for (int i = 0; i < s_out_len; i++)
+      if (s_out_keys[i] >= 0) s_out_slots[s_out_keys[i]] = -1;
+
+    s_out_len = 0;
+    s_out_bytes += bytes;
+    s_sched_tokens -= bytes * 1000;
+    if (s_sched_tokens < -OUTRATE * SCHEDBURST) s_sched_tokens = -OUTRATE * SCHEDBURST;
+
+    return bytes;
+  } // MIDIOut_Flush
 
 
-  void MIDIOut(unsigned char s, unsigned char d1, unsigned char d2) 
+  template <int handler> void MIDIOutCtl(char ch_id, unsigned char value)
   {
-    if (m_midiout) m_midiout->Send(s, d1, d2, 0);
-  } // void MIDIOut(char s, char d1, char d2)
+    // cc per channel from the control map, see csurf_us2400_protocol.h
+    MIDIOut(Prt_Out<handler>::status, Prt_Out<handler>::CC(ch_id), value);
+  } // MIDIOutCtl
 
 
 
@@ -850,8 +1120,11 @@ class CSurf_US2400 : public IReaperControlSurface
     } else
     {
       s_touch_fdr = s_touch_fdr & (~(1 << ch_id));
+
+      // put the motor where it belongs first thing
+      s_sched_moved = s_sched_moved | (1 << ch_id);
     }
-    
+
     Stp_Update(ch_id);
   } // OnFaderTouch
 
@@ -869,7 +1142,7 @@ class CSurf_US2400 : public IReaperControlSurface
 
     // is track or master?
     if ( (ch_id >= 0) && (ch_id <= 23) ) istrack = true; // no track fader
-    else if (rpr_tk == CSurf_TrackFromID(0, false)) ismaster = true;
+    else if (rpr_tk == Cnv_ChannelIDToMediaTrack(24)) ismaster = true;
 
     // active fader? 
     if (!rpr_tk) isactive = false; // no corresponding rpr_tk
@@ -964,7 +1237,7 @@ class CSurf_US2400 : public IReaperControlSurface
   } // OnFaderChange()
 
 
-  void OnEncoderChange(char ch_id, signed char rel_value)
+  void OnEncoderChange(int ch_id, double rel_value)
   {
     MediaTrack* rpr_tk = Cnv_ChannelIDToMediaTrack(ch_id);
     int para_amount;
@@ -1046,6 +1319,10 @@ class CSurf_US2400 : public IReaperControlSurface
             } else if (step != 0)
             {
               has_steps = true;
+
+              // accelerated: whole steps only
+              if (rel_value > 0) rel_value = (double)F2I(rel_value);
+              else rel_value = -(double)F2I(-rel_value);
             
               if (q_fkey)
               {
@@ -1175,11 +1452,11 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void OnAux(char sel)
   { 
-    char mode = 0;
+    int mode = 0;
     if (m_chan) mode = 1;
     else if (m_aux > 0) mode = 2;
     
-    char qkey = 0;
+    int qkey = 0;
     if (q_shift) qkey = 1;
     else if (q_fkey) qkey = 2;
     else if (q_mkey) qkey = 3;
@@ -1207,9 +1484,17 @@ class CSurf_US2400 : public IReaperControlSurface
 
 
   void OnMeter()
+  {
+    // shift: switch meter / m-key mode, not within this cycle's Run<meter>
+    if (q_shift) m_meter_toggle = !m_meter_toggle;
+    else (this->*p_on_meter)();
+  } // OnMeter
+
+
+  template <bool meter> void OnMeter()
   {
     // reset holds
-    if (METERMODE) MySetSurface_OutputMeters(true);
+    if (meter) MySetSurface_OutputMeters(true);
     // reset button
     else {
       q_mkey = !q_mkey;
@@ -1223,7 +1508,7 @@ class CSurf_US2400 : public IReaperControlSurface
 
       MySetSurface_UpdateButton(0x6b, q_mkey, false);
     }
-  } // OnMeter
+  } // OnMeter<meter>
 
 
   // QUALIFIERS
@@ -1250,11 +1535,11 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void OnRew()
   {
-    char mode = 0;
+    int mode = 0;
     if (m_chan) mode = 1;
     else if (m_aux > 0) mode = 2;
     
-    char qkey = 0;
+    int qkey = 0;
     if (q_shift) qkey = 1;
     else if (q_fkey) qkey = 2;
     else if (q_mkey) qkey = 3;
@@ -1267,11 +1552,11 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void OnFwd()
   {
-    char mode = 0;
+    int mode = 0;
     if (m_chan) mode = 1;
     else if (m_aux > 0) mode = 2;
     
-    char qkey = 0;
+    int qkey = 0;
     if (q_shift) qkey = 1;
     else if (q_fkey) qkey = 2;
     else if (q_mkey) qkey = 3;
@@ -1284,11 +1569,11 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void OnStop()
   {
-    char mode = 0;
+    int mode = 0;
     if (m_chan) mode = 1;
     else if (m_aux > 0) mode = 2;
     
-    char qkey = 0;
+    int qkey = 0;
     if (q_shift) qkey = 1;
     else if (q_fkey) qkey = 2;
     else if (q_mkey) qkey = 3;
@@ -1301,11 +1586,11 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void OnPlay()
   {
-    char mode = 0;
+    int mode = 0;
     if (m_chan) mode = 1;
     else if (m_aux > 0) mode = 2;
     
-    char qkey = 0;
+    int qkey = 0;
     if (q_shift) qkey = 1;
     else if (q_fkey) qkey = 2;
     else if (q_mkey) qkey = 3;
@@ -1318,11 +1603,11 @@ class CSurf_US2400 : public IReaperControlSurface
 
   void OnRec()
   {
-    char mode = 0;
+    int mode = 0;
     if (m_chan) mode = 1;
     else if (m_aux > 0) mode = 2;
     
-    char qkey = 0;
+    int qkey = 0;
     if (q_shift) qkey = 1;
     else if (q_fkey) qkey = 2;
     else if (q_mkey) qkey = 3;
@@ -1338,11 +1623,11 @@ class CSurf_US2400 : public IReaperControlSurface
   {
     if (btn_state) 
     {
-      char mode = 0;
+      int mode = 0;
       if (m_chan) mode = 1;
       else if (m_aux > 0) mode = 2;
       
-      char qkey = 0;
+      int qkey = 0;
       if (q_shift) qkey = 1;
       else if (q_fkey) qkey = 2;
       else if (q_mkey) qkey = 3;
@@ -1426,7 +1711,7 @@ class CSurf_US2400 : public IReaperControlSurface
 
   // SPECIAL INPUT  
 
-  void OnJogWheel(signed char rel_value)
+  void OnJogWheel(double rel_value)
   {
     if (m_scrub)
     {
@@ -1461,6 +1746,10 @@ class CSurf_US2400 : public IReaperControlSurface
       stp_hwnd = CreateWindowEx(WS_EX_TOOLWINDOW | WS_EX_TOPMOST | WS_EX_NOACTIVATE, "stp", "US-2400 Display", WS_THICKFRAME | WS_POPUP, stp_x, stp_y, stp_width, stp_height, NULL, NULL, g_hInst, NULL);
     }
 
+    // track numbers and colors are only read while the strip is open
+    s_chs_poll = 0x1ffffff;
+    Utl_PollChannels(false);
+
     for (int ch = 0; ch < 24; ch++) Stp_Update(ch);
 
     ShowWindow(stp_hwnd, SW_SHOW);
@@ -1489,7 +1778,6 @@ class CSurf_US2400 : public IReaperControlSurface
       MediaTrack* tk;
       int tk_num, fx_amount;
       char buffer[64];
-      WDL_String tk_name;
       WDL_String tk_num_c;
       WDL_String par_name;
       WDL_String par_val;    
@@ -1499,39 +1787,38 @@ class CSurf_US2400 : public IReaperControlSurface
 
       // get info
 
-      tk = Cnv_ChannelIDToMediaTrack(ch);
-      if (tk != NULL) 
+      ChannelState* chs = &s_chs[ch];
+      tk = chs->tk;
+      if (tk != NULL)
       {
         // track number
-        tk_num = (int)GetMediaTrackInfo_Value(tk, "IP_TRACKNUMBER");
+        tk_num = chs->tk_num;
         sprintf(buffer, "%d", tk_num);
         tk_num_c = WDL_String(buffer);
 
-        // track name
-        GetSetMediaTrackInfo_String(tk, "P_NAME", buffer, false);
-        buffer[63] = '\0';
-        tk_name = WDL_String(buffer);
-      
-        // track mute, selected, rec arm
-        int flags;
-        GetTrackState(tk, &flags);
-
+        // track name, only read if SetTrackTitle didn't tell
+        if ((s_names_valid & (1 << ch)) == 0)
+        {
+          GetSetMediaTrackInfo_String(tk, "P_NAME", buffer, false);
+          buffer[63] = '\0';
+          Utl_StoreTrackName(ch, buffer);
+        }
+            
         // muted
-        if ( (bool)(flags & 8) ) stp_mute = stp_mute | (1 << ch);
+        if (chs->mute) stp_mute = stp_mute | (1 << ch);
         else stp_mute = stp_mute & (~(1 << ch));
 
         // selected
-        if ( (bool)(flags & 2) ) stp_sel = stp_sel | (1 << ch);
+        if (chs->sel) stp_sel = stp_sel | (1 << ch);
         else stp_sel = stp_sel & (~(1 << ch));
 
         // armed
-        if ( (bool)(flags & 64) ) stp_rec = stp_rec | (1 << ch);
+        if (chs->recarm) stp_rec = stp_rec | (1 << ch);
         else stp_rec = stp_rec & (~(1 << ch));
 
       } else
       {
         tk_num_c = "";
-        tk_name = "";
         stp_colors[ch] = 0;
         stp_mute = stp_mute & (~(1 << ch));
         stp_sel = stp_sel & (~(1 << ch));
@@ -1539,7 +1826,9 @@ class CSurf_US2400 : public IReaperControlSurface
       }
 
 
-      fx_amount = TrackFX_GetNumParams(tk, chan_fx);
+      // fx params are only shown in chan mode
+      fx_amount = 0;
+      if (m_chan) fx_amount = TrackFX_GetNumParams(tk, chan_fx);
       if (ch + chan_par_offs < fx_amount)
       {
         // fx param value
@@ -1565,8 +1854,9 @@ class CSurf_US2400 : public IReaperControlSurface
       // transmit
 
       stp_chan = false;
-      stp_colors[ch] = GetTrackColor(tk);
-      stp_strings[ch + 24] = tk_name;
+      stp_colors[ch] = chs->color;
+      if (tk != NULL) stp_strings[ch + 24].Set(s_names[ch].Get());
+      else stp_strings[ch + 24].Set("");
       stp_strings[ch] = tk_num_c;
       stp_flip = m_flip;
 
@@ -1579,16 +1869,14 @@ class CSurf_US2400 : public IReaperControlSurface
         {
           stp_colors[ch] = 0;
           stp_strings[ch + 24] = par_name;
+          Utl_Alphanumeric(stp_strings[ch + 24].Get());
         }
 
         TrackFX_GetFXName(chan_rpr_tk, chan_fx, buffer, 64);
-        stp_strings[49] = WDL_String(buffer);
-        stp_strings[49] = Utl_Alphanumeric(stp_strings[49]);
+        Utl_Alphanumeric(buffer);
+        stp_strings[49].Set(buffer);
       }
 
-      // keep only alphanumeric, replace everything else with space
-      stp_strings[ch + 24] = Utl_Alphanumeric(stp_strings[ch + 24]);
-
       stp_repaint = true;
     }
   } // Stp_Update
@@ -1987,62 +2275,338 @@ class CSurf_US2400 : public IReaperControlSurface
 
   int Cnv_MediaTrackToChannelID(MediaTrack* rpr_tk)
   {
-    int ch_id = CSurf_TrackToID(rpr_tk, g_csurf_mcpmode);
+    // -1 = not on the surface (other bank)
+    int ch_id = -1;
+
+    if (rpr_tk != NULL)
+    {
+      int slot = Cnv_BankHashSlot(rpr_tk);
+      while (s_bank_hash_tks[slot] != NULL)
+      {
+        if (s_bank_hash_tks[slot] == rpr_tk)
+        {
+          ch_id = s_bank_hash_chs[slot];
+          break;
+        }
+        slot = (slot + 1) & (BANKHASHSIZE - 1);
+      }
+    }
+
+#ifdef _DEBUG
+    // cache missed a track list change?
+    int id = CSurf_TrackToID(rpr_tk, g_csurf_mcpmode);
+    if (id == 0) id = 24; // master
+    else
+    {
+      id = id - s_ch_offset - 1;
+      if ( (id < 0) || (id > 23) ) id = -1;
+    }
 
-    ch_id -= s_ch_offset;
-    if (ch_id == 0) ch_id = 24;
-    else ch_id = ch_id - 1;
+    if (id != ch_id)
+    {
+      sprintf(debug, "US-2400: bank hash stale (ch %d/%d)\n", ch_id, id);
+      DBGS(debug);
+    }
+#endif
 
     return ch_id;
   } // Cnv_MediaTrackToChannelID
 
 
+  int Cnv_BankHashSlot(MediaTrack* rpr_tk)
+  {
+    // fibonacci hashing of the pointer, alignment bits dropped
+    unsigned int h = (unsigned int)((size_t)rpr_tk >> 4) * 2654435761u;
+    return (int)(h >> 26) & (BANKHASHSIZE - 1);
+  } // Cnv_BankHashSlot
+
+
   MediaTrack* Cnv_ChannelIDToMediaTrack(unsigned char ch_id) 
   {
-    if (ch_id == 24) 
+    if (ch_id > 24) return CSurf_TrackFromID(ch_id + s_ch_offset + 1, g_csurf_mcpmode);
+
+#ifdef _DEBUG
+    // cache missed a track list change? report only, release builds can't repair it either
+    MediaTrack* rpr_tk = CSurf_TrackFromID((ch_id == 24) ? 0 : ch_id + s_ch_offset + 1, g_csurf_mcpmode);
+    if (rpr_tk != s_bank_tks[ch_id])
     {
-      ch_id = 0; // master = 0
-    } else 
-    { 
-      ch_id += s_ch_offset + 1;
+      sprintf(debug, "US-2400: bank cache stale (ch %d)\n", ch_id);
+      DBGS(debug);
     }
-    
-    MediaTrack* rpr_tk = CSurf_TrackFromID(ch_id, g_csurf_mcpmode);
+#endif
 
-    return rpr_tk;
+    return s_bank_tks[ch_id];
   } // Cnv_ChannelIDToMediaTrack
 
 
-  int Cnv_AuxIDToSendID(int ch_id, char aux)
+  void Utl_UpdateBankCache()
+  {
+    // on init, bank shift, track list change and project switch only
+    for (int ch_id = 0; ch_id < 24; ch_id++)
+    {
+      MediaTrack* tk = CSurf_TrackFromID(ch_id + s_ch_offset + 1, g_csurf_mcpmode);
+
+      // other track, other meter and name
+      if (tk != s_bank_tks[ch_id])
+      {
+        Utl_ResetMeter(ch_id);
+        s_names_valid = s_names_valid & (~(1 << ch_id));
+      }
+      s_bank_tks[ch_id] = tk;
+    }
+
+    if (s_sampler) s_sampler->Mtr_Publish(s_bank_tks);
+    
+    s_bank_tks[24] = CSurf_TrackFromID(0, g_csurf_mcpmode); // master = 0
+
+    s_bank_project = EnumProjects(-1, NULL, 0);
+
+    // reverse lookup for REAPER's callbacks
+    for (int slot = 0; slot < BANKHASHSIZE; slot++) s_bank_hash_tks[slot] = NULL;
+
+    for (int ch_id = 0; ch_id < 25; ch_id++)
+    {
+      if (s_bank_tks[ch_id] == NULL) continue;
+
+      int slot = Cnv_BankHashSlot(s_bank_tks[ch_id]);
+      while ( (s_bank_hash_tks[slot] != NULL) && (s_bank_hash_tks[slot] != s_bank_tks[ch_id]) ) 
+        slot = (slot + 1) & (BANKHASHSIZE - 1);
+
+      // same track twice: keep the first channel
+      if (s_bank_hash_tks[slot] != NULL) continue;
+
+      s_bank_hash_tks[slot] = s_bank_tks[ch_id];
+      s_bank_hash_chs[slot] = ch_id;
+    }
+
+    // other tracks, other sends
+    s_aux_indexed = 0;
+    s_chs_poll = 0x1ffffff;
+  } // Utl_UpdateBankCache
+
+
+  void Utl_PollChannels(bool derive)
+  {
+    // read the flagged channels in one pass, then flag only what changed
+    // for Utl_UpdateChannels (derive = false: caller refreshes everything anyway)
+    unsigned long upd_elem = 0;
+    unsigned long upd_enc = 0;
+    unsigned long upd_stp = 0;
+    unsigned long polled = s_chs_poll;
+    bool strip = (stp_hwnd != NULL);
+
+    for (int ch_id = 0; ch_id < 25; ch_id++)
+    {
+      if ((s_chs_poll & (1 << ch_id)) == 0) continue;
+
+      ChannelState now;
+      now.tk = Cnv_ChannelIDToMediaTrack(ch_id);
+      now.tk_num = 0;
+      now.color = 0;
+      now.sel = now.solo = now.mute = false;
+      now.fxen = now.phase = now.recarm = false;
+
+      if (now.tk != NULL)
+      {
+        int flags;
+        GetTrackState(now.tk, &flags);
+        now.sel = ((flags & 2) > 0);
+        now.mute = ((flags & 8) > 0);
+        now.solo = ((flags & 16) > 0);
+        now.recarm = ((flags & 64) > 0);
+
+        // master: select only
+        if (ch_id < 24)
+        {
+          now.fxen = (bool)GetMediaTrackInfo_Value(now.tk, "I_FXEN");
+          now.phase = (bool)GetMediaTrackInfo_Value(now.tk, "B_PHASE");
+
+          if (strip)
+          {
+            now.tk_num = (int)GetMediaTrackInfo_Value(now.tk, "IP_TRACKNUMBER");
+            now.color = GetTrackColor(now.tk);
+          }
+        }
+      }
+
+      ChannelState* was = &s_chs[ch_id];
+      bool new_tk = (now.tk != was->tk);
+
+      if ( new_tk || (now.sel != was->sel) || (now.solo != was->solo) || (now.mute != was->mute) || (now.fxen != was->fxen) )
+        upd_elem = upd_elem | (1 << ch_id);
+
+      if ( new_tk || (now.phase != was->phase) || (now.recarm != was->recarm) )
+        upd_enc = upd_enc | (1 << ch_id);
+
+      if ( new_tk || (now.sel != was->sel) || (now.mute != was->mute) || (now.recarm != was->recarm)
+        || (now.tk_num != was->tk_num) || (now.color != was->color) )
+        upd_stp = upd_stp | (1 << ch_id);
+
+      *was = now;
+    }
+
+    s_chs_poll = 0;
+    if (!derive) return;
+
+    // master: select only, see below
+    s_upd_elem = s_upd_elem | (upd_elem & 0xffffff);
+    s_upd_enc = s_upd_enc | (upd_enc & 0xffffff);
+    if (strip) s_upd_stp = s_upd_stp | (upd_stp & 0xffffff);
+
+    // any selection may change the master's blink
+    if ((polled & (1 << 24)) > 0) MySetSurface_UpdateMasterSel();
+  } // Utl_PollChannels
+
+
+  void Utl_UpdateChannels()
+  {
+    // once per Run(): however many callbacks came, each flagged
+    // element is read and set only once
+    unsigned long fdr = s_upd_fdr;
+    unsigned long enc = s_upd_enc;
+    unsigned long elem = s_upd_elem;
+    unsigned long stp = (stp_hwnd != NULL) ? s_upd_stp : 0;
+
+    s_upd_fdr = 0;
+    s_upd_enc = 0;
+    s_upd_elem = 0;
+    s_upd_stp = 0;
+
+    // walk the flagged channels only
+    unsigned long chs = fdr | enc | elem | stp;
+    while (chs != 0)
+    {
+      char ch_id = (char)Fb_Frame::Fb_Ctz(chs);
+      unsigned long bit = (1UL << ch_id);
+      chs = chs & (~bit);
+
+      if ((fdr & bit) > 0) MySetSurface_UpdateFader(ch_id);
+      if ((enc & bit) > 0) MySetSurface_UpdateEncoder(ch_id);
+      if ((elem & bit) > 0) MySetSurface_UpdateTrackElement(ch_id);
+      if ((stp & bit) > 0) Stp_Update(ch_id);
+    }
+
+    // update CLR SOLO, any track counts
+    if (s_upd_clrsolo)
+    {
+      s_upd_clrsolo = false;
+      if (AnyTrackSolo(0)) MySetSurface_UpdateButton(0x62, true, true);
+      else MySetSurface_UpdateButton(0x62, false, false);
+    }
+  } // Utl_UpdateChannels
+
+
+  void Utl_IndexAuxSends(int ch_id)
   {
-    char search[256];
+    // one pass over the channel's sends for all aux 1-6,
+    // on first use after a bank / track list / send change
+    char search[6][16];
     char sendname[256];
-    sprintf(search, AUXSTRING, aux);
 
-    MediaTrack* rpr_tk = Cnv_ChannelIDToMediaTrack(ch_id);
-    int all_sends = GetTrackNumSends(rpr_tk, 0);
-    // hardware outputs count for GetTrackSendName, too
-    all_sends += GetTrackNumSends(rpr_tk, 1);
+    for (int aux = 0; aux < 6; aux++)
+    {
+      sprintf(search[aux], AUXSTRING, aux + 1);
+      s_aux_sends[ch_id][aux] = -1;
+      s_aux_pre[ch_id][aux] = false;
+      s_aux_dest[ch_id][aux] = NULL;
+    }
 
-    for (int s = 0; s < all_sends; s++)
+    MediaTrack* rpr_tk = Cnv_ChannelIDToMediaTrack(ch_id);
+    if (rpr_tk != NULL)
     {
-      GetTrackSendName(rpr_tk, s, sendname, 256);
+      int all_sends = GetTrackNumSends(rpr_tk, 0);
+      // hardware outputs count for GetTrackSendName, too
+      all_sends += GetTrackNumSends(rpr_tk, 1);
+      s_aux_count[ch_id] = all_sends;
+
+      for (int s = 0; s < all_sends; s++)
+      {
+        GetTrackSendName(rpr_tk, s, sendname, 256);
           
-      // lowercase name - surely there has to be a better way?
-      char c = 0;
-      while ((c < 256) && (sendname[c] != 0))
+        // lowercase name
+        int c = 0;
+        while ((c < 256) && (sendname[c] != 0))
+        {
+          if ((sendname[c] >= 65) && (sendname[c] <= 90)) sendname[c] += 32;
+          c++;
+        }
+
+        // first send wins
+        for (int aux = 0; aux < 6; aux++)
+        {
+          if ( (s_aux_sends[ch_id][aux] == -1) && (strstr(sendname, search[aux])) )
+          {
+            s_aux_sends[ch_id][aux] = s;
+            s_aux_dest[ch_id][aux] = (MediaTrack*)GetSetTrackSendInfo(rpr_tk, 0, s, "P_DESTTRACK", NULL);
+
+            int* send_mode = (int*)GetSetTrackSendInfo(rpr_tk, 0, s, "I_SENDMODE", NULL);
+            if ( (send_mode != NULL) && (*send_mode > 0) ) s_aux_pre[ch_id][aux] = true;
+          }
+        }
+      }
+    }
+
+    s_aux_indexed = s_aux_indexed | (1 << ch_id);
+  } // Utl_IndexAuxSends
+
+
+  void Utl_CheckAuxSends()
+  {
+    // sends added, removed, retargeted or switched pre / post outside the
+    // surface: index again on next use, aux mode shows it right away
+    // (the surface's own add / remove / switch drop the index right away)
+    for (int ch_id = 0; ch_id < 25; ch_id++)
+    {
+      if ((s_aux_indexed & (1 << ch_id)) == 0) continue;
+
+      MediaTrack* rpr_tk = Cnv_ChannelIDToMediaTrack(ch_id);
+      int all_sends = 0;
+      if (rpr_tk != NULL) all_sends = GetTrackNumSends(rpr_tk, 0) + GetTrackNumSends(rpr_tk, 1);
+
+      bool valid = (all_sends == s_aux_count[ch_id]);
+      for (int aux = 0; (valid) && (aux < 6); aux++)
       {
-        if ((sendname[c] >= 65) && (sendname[c] <= 90)) sendname[c] += 32;
-        c++;
+        int s = s_aux_sends[ch_id][aux];
+        if (s == -1) continue;
+
+        MediaTrack* dest = (MediaTrack*)GetSetTrackSendInfo(rpr_tk, 0, s, "P_DESTTRACK", NULL);
+        int* send_mode = (int*)GetSetTrackSendInfo(rpr_tk, 0, s, "I_SENDMODE", NULL);
+        bool pre = ( (send_mode != NULL) && (*send_mode > 0) );
+
+        if ( (dest != s_aux_dest[ch_id][aux]) || (pre != s_aux_pre[ch_id][aux]) ) valid = false;
       }
 
-      if (strstr(sendname, search)) return s;
+      if (!valid)
+      {
+        s_aux_indexed = s_aux_indexed & (~(1 << ch_id));
+        if ( (m_aux > 0) && (ch_id < 24) )
+        {
+          s_upd_enc = s_upd_enc | (1 << ch_id);
+          s_upd_fdr = s_upd_fdr | (1 << ch_id); // flip: send level
+        }
+      }
     }
-    
-    return -1;
+  } // Utl_CheckAuxSends
+
+
+  int Cnv_AuxIDToSendID(int ch_id, char aux)
+  {
+    if ( (aux < 1) || (aux > 6) ) return -1;
+
+    if ((s_aux_indexed & (1 << ch_id)) == 0) Utl_IndexAuxSends(ch_id);
+
+    return s_aux_sends[ch_id][aux - 1];
   } // Cnv_AuxIDToSendID
 
 
+  bool Cnv_AuxIDIsPre(int ch_id, char aux)
+  {
+    if (Cnv_AuxIDToSendID(ch_id, aux) == -1) return false;
+
+    return s_aux_pre[ch_id][aux - 1];
+  } // Cnv_AuxIDIsPre
+
+
   // VOLUME / SEND LEVELS
 
   double Cnv_FaderToVol(unsigned int value) 
@@ -2050,44 +2614,32 @@ class CSurf_US2400 : public IReaperControlSurface
     // theoretically, the MIDI range is from 0 to 16383,
     // but the US2400 gets a little rough on the ends, 
     // an attempt to account for that:
-    double new_val = ((double)(value + 41) * 1000.0) / 16256.0;
-
-    if (new_val < 0.0) new_val = 0.0;
-    else if (new_val > 1000.0) new_val = 1000.0;
+    double new_val = ((double)(value + 41) * (double)TPR_MAX) / 16256.0;
 
-    new_val = SLIDER2DB(new_val);
-    new_val = DB2VAL(new_val);
-
-    return(new_val);
+    // taper table, see csurf_us2400_taper.h (clamps to range)
+    return Tpr_PosToGain(new_val);
   } // Cnv_FaderToVol
 
 
-  double Cnv_EncoderToVol(double old_val, signed char rel_val) 
+  double Cnv_EncoderToVol(double old_val, double rel_val) 
   {
-    double lin = (DB2SLIDER( VAL2DB(old_val) ) * 16383.0 / 1000.0);
-    double d_rel = (double)rel_val * (double)ENCRESVOL;
+    double lin = Tpr_GainToPos(old_val);
+    double d_rel = rel_val * (double)ENCRESVOL;
     lin = lin + d_rel;
 
-    double new_val = ((double) lin * 1000.0) / 16383.0;
-
-    if (new_val < 0.0) new_val = 0.0;
-    else if (new_val > 1000.0) new_val = 1000.0;
-
-    new_val = DB2VAL(SLIDER2DB(new_val));
-
-    return new_val;
+    // taper table, see csurf_us2400_taper.h (clamps to range)
+    return Tpr_PosToGain(lin);
   } // Cnv_EncoderToVol
 
 
   int Cnv_VolToFader(double value) 
   {
-    double new_val = VAL2DB(value);
-    new_val = DB2SLIDER( new_val );
+    double new_val = Tpr_GainToPos(value);
 
     // theoretically, the MIDI range is from 0 to 16383,
     // but the US2400 gets a little rough on the ends, 
     // an attempt to account for that:
-    new_val = new_val * 16256.0 / 1000.0 + 41;
+    new_val = new_val * 16256.0 / (double)TPR_MAX + 41;
 
     int out;
 
@@ -2102,7 +2654,7 @@ class CSurf_US2400 : public IReaperControlSurface
 
   unsigned char Cnv_VolToEncoder(double value) 
   {
-    double new_val = (DB2SLIDER( VAL2DB(value) ) * 14.0 / 1000.0) + 1;
+    double new_val = (Tpr_GainToPos(value) * 14.0 / (double)TPR_MAX) + 1;
 
     if (new_val < 1.0) new_val = 1.0;
     else if (new_val > 15.0) new_val = 15.0;
@@ -2111,25 +2663,6 @@ class CSurf_US2400 : public IReaperControlSurface
   } // Cnv_VolToEncoder
 
 
-  unsigned char Cnv_PeakToEncoder(double value) 
-  {
-    double new_val = VAL2DB(value);
-
-    return Cnv_DBToEncoder(new_val);
-  } // Cnv_PeakToEncoder
-
-
-  unsigned char Cnv_DBToEncoder(double value)
-  {
-    if (value > MINUSINF) value = ((MINUSINF - value) / MINUSINF * 15.0) + 0.5;
-    else value = 0.0;
-
-    if (value > 15.0) value = 15.0;
-
-    return char(value);
-  } //Cnv_DBToEncoder
-
-
   // PAN / WIDTH
 
   double Cnv_FaderToPanWidth(unsigned int value) 
@@ -2143,9 +2676,9 @@ class CSurf_US2400 : public IReaperControlSurface
   } // Cnv_FaderToPanWidth
 
 
-  double Cnv_EncoderToPanWidth(double old_val, signed char rel_val) 
+  double Cnv_EncoderToPanWidth(double old_val, double rel_val) 
   { 
-    double new_val = old_val + (double)rel_val * (double)ENCRESPAN;
+    double new_val = old_val + rel_val * (double)ENCRESPAN;
 
     if (new_val < -1.0) new_val = -1.0;
     else if (new_val > 1.0) new_val = 1.0;
@@ -2198,14 +2731,14 @@ class CSurf_US2400 : public IReaperControlSurface
   } // Cnv_FaderToFXParam
 
 
-  double Cnv_EncoderToFXParam(double old_val, double min, double max, double step, signed char rel_val)  
+  double Cnv_EncoderToFXParam(double old_val, double min, double max, double step, double rel_val)  
   {
     /* should TrackFX_GetParamStepSizes decide to work, we can use this: 
-    double d_rel = (double)rel_val * step;
+    double d_rel = rel_val * step;
     */
 
     // for now:
-    double d_rel = (double)rel_val * (max - min) * step;
+    double d_rel = rel_val * (max - min) * step;
 
     double new_val = old_val + d_rel;
 
@@ -2240,6 +2773,26 @@ class CSurf_US2400 : public IReaperControlSurface
 
   // HELPERS
 
+  double Utl_Accelerate(int ticks, DWORD* last)
+  {
+    // ticks of one cycle -> steps, scaled by turning speed (ticks per second)
+    DWORD dt = s_run_time - *last;
+    *last = s_run_time;
+
+    double factor = 1.0;
+    if ( (dt < ENCACCELGAP) && (abs(ticks) > 1) )
+    {
+      if (dt < 1) dt = 1;
+      factor = (double)abs(ticks) * 1000.0 / (double)dt / (double)ENCACCELMIN;
+
+      if (factor < 1.0) factor = 1.0;
+      else if (factor > ENCACCELMAX) factor = ENCACCELMAX;
+    }
+
+    return (double)ticks * factor;
+  } // Utl_Accelerate
+
+
   void Utl_SaveSelection()
   {
     if (saved_sel == 0)
@@ -2360,34 +2913,70 @@ class CSurf_US2400 : public IReaperControlSurface
   } // Utl_GetCustomCmdIds
 
 
-  void Utl_CheckFXInsert()
+  void Utl_UpdateChanFX()
   {
-    int real_fx_count = TrackFX_GetCount(chan_rpr_tk);
-    if (chan_fx_count != real_fx_count)
+    // apply what Extended() was told about the chan track's fx
+    if (chan_fx_changed)
     {
-     
-      chan_fx_count = real_fx_count;
-      chan_fx = chan_fx_count - 1;
+      chan_fx_changed = false;
+      Utl_CheckFXInsert();
+    }
 
-      // update display and encoders / faders
-      for (int ch = 0; ch < 24; ch++)
+    if (chan_fx_opened >= 0)
+    {
+      int fx_id = chan_fx_opened;
+      chan_fx_opened = -1;
+
+      // opened in REAPER: show its params, leave the windows alone
+      if ( (fx_id != chan_fx) && (fx_id < TrackFX_GetCount(chan_rpr_tk)) )
       {
-        Stp_Update(ch);
-        if (!m_flip) MySetSurface_UpdateEncoder(ch);
-        else MySetSurface_UpdateFader(ch);
+        chan_fx = fx_id;
+        chan_par_offs = 0;
+
+        MySetSurface_UpdateAuxButtons();
+        Utl_UpdateChanParams();
       }
+    }
+  } // Utl_UpdateChanFX
+
+
+  void Utl_UpdateChanParams()
+  {
+    // encoders or faders and scribble strip
+    for (char ch_id = 0; ch_id <= 23; ch_id++)
+    {
+      if (m_flip) MySetSurface_UpdateFader(ch_id);
+      else MySetSurface_UpdateEncoder(ch_id);
+
+      if (stp_hwnd != NULL) Stp_Update(ch_id);
+    }
+  } // Utl_UpdateChanParams
+
+
+  void Utl_CheckFXInsert()
+  {
+    int real_fx_count = TrackFX_GetCount(chan_rpr_tk);
+    if (chan_fx_count != real_fx_count)
+    {
+     
+      chan_fx_count = real_fx_count;
+      chan_fx = chan_fx_count - 1;
 
       MyCSurf_Chan_OpenFX(chan_fx);
+
+    } else
+    {
+      // moved: another fx may be at chan_fx now
+      Utl_UpdateChanParams();
     }
   } // Utl_CheckFXInsert
 
 
-  WDL_String Utl_Alphanumeric(WDL_String in_str)
+  void Utl_Alphanumeric(char* str_buf)
   {
-    char* str_buf = in_str.Get();
     bool replace = false;
-    // replace everything other than A-Z, a-z, 0-9 with a space
-    for (int i = 0; i < (int)strlen(str_buf); i++)
+    // replace everything other than A-Z, a-z, 0-9 with a space, in place
+    for (int i = 0; str_buf[i] != '\0'; i++)
     {
       replace = true;
       if (str_buf[i] == '\n') replace = false;
@@ -2397,40 +2986,61 @@ class CSurf_US2400 : public IReaperControlSurface
 
       if (replace) str_buf[i] = ' ';
     }
-
-    WDL_String out_str = WDL_String(str_buf);
-    return out_str;
   } // Utl_Alphanumeric
 
 
+  void Utl_StoreTrackName(int ch_id, const char* name)
+  {
+    // from SetTrackTitle or read once by Stp_Update
+    s_names[ch_id].Set(name);
+    Utl_Alphanumeric(s_names[ch_id].Get());
+    s_names_valid = s_names_valid | (1 << ch_id);
+  } // Utl_StoreTrackName
+
+
   MediaTrack* Utl_FindAux(int aux_id)
   {
-    MediaTrack* tk;
-    
+    if ( (aux_id < 1) || (aux_id > 6) ) return NULL;
+    if (!s_aux_buses_valid) Utl_IndexAuxBuses();
+
+    return s_aux_buses[aux_id];
+  } // Utl_FindAux
+
+
+  void Utl_IndexAuxBuses()
+  {
+    // aux number -> track for tracks named "aux---1" to "aux---6" (any case),
+    // rebuilt on first use after a track list or title change
+    char name[256];
+
+    for (int aux_id = 0; aux_id <= 6; aux_id++) s_aux_buses[aux_id] = NULL;
+
     for (int tk_id = 0; tk_id < CountTracks(0); tk_id++)
     {
-      tk = GetTrack(0, tk_id);
-      const char* name = GetTrackState(tk, 0);
-      
-      // lowercase aux
+      MediaTrack* tk = GetTrack(0, tk_id);
+      const char* tk_name = GetTrackState(tk, 0);
+      if (tk_name == NULL) continue;
+
+      // lowercase name
       int c = 0;
-      int chr_found = 0;
-      while ((name[c] != '\0') && (c < (int)strlen(name)))
+      while ((c < 255) && (tk_name[c] != '\0'))
       {
-        if (chr_found == 0 && ((name[c] == 'A') || (name[c] == 'a'))) chr_found = 1;
-        else if (chr_found == 1 && ((name[c] == 'U') || (name[c] == 'u'))) chr_found = 2;
-        else if (chr_found == 2 && ((name[c] == 'X') || (name[c] == 'x'))) chr_found = 3;
-        else if ((chr_found >= 3) && (chr_found <= 5) && (name[c] == '-')) chr_found++;
-        else if ((chr_found == 6) && (name[c] == (aux_id + 48))) chr_found = 7;
-
-        if (chr_found == 7) return tk;
-
+        name[c] = tk_name[c];
+        if ((name[c] >= 'A') && (name[c] <= 'Z')) name[c] += 32;
         c++;
       }
+      name[c] = '\0';
+
+      const char* pos = strstr(name, "aux---");
+      if ( (pos == NULL) || (pos[6] < '0') || (pos[6] > '9') ) continue;
+
+      // first track wins
+      int aux_id = atoi(pos + 6);
+      if ( (aux_id >= 1) && (aux_id <= 6) && (s_aux_buses[aux_id] == NULL) ) s_aux_buses[aux_id] = tk;
     }
-    
-    return NULL;
-  }
+
+    s_aux_buses_valid = true;
+  } // Utl_IndexAuxBuses
 
   WDL_String Utl_Chunk_InsertLine(WDL_String chunk, WDL_String line, WDL_String before)
   {
@@ -2489,55 +3099,115 @@ public:
 
   ////// CONSTRUCTOR / DESTRUCTOR //////
 
-  CSurf_US2400(int indev, int outdev, int *errStats)
+  CSurf_US2400(int indev, int outdev, bool meter, int *errStats)
   {
     ////// GLOBAL VARS //////
 
     m_midi_in_dev = indev;
     m_midi_out_dev = outdev;
 
+    Utl_SelectMeterMode(meter);
+    m_meter_toggle = false;
+
     m_offset = 0;
     m_size = 0;
 
 
     // reset cmd_ids
-    for (char qkey = 0; qkey < 4; qkey++)
-      for (char mode = 0; mode < 3; mode++)
-        for (char key = 0; key < 12; key++)
+    for (int qkey = 0; qkey < 4; qkey++)
+      for (int mode = 0; mode < 3; mode++)
+        for (int key = 0; key < 12; key++)
           cmd_ids[qkey][mode][key] = -1;
 
+    s_run_time = timeGetTime();
+
+    // volume taper tables, built once with the host's curve
+    if (!tpr_ready) Tpr_Init(SLIDER2DB, MINUSINF);
+
     // for fader data
-    waitformsb = false;
+    s_fdr_lsb_mask = 0;
+    s_fdr_pending_mask = 0;
+    for (int i = 0; i < 25; i++) 
+    {
+      s_fdr_lsb[i] = 0;
+      s_fdr_lsb_time[i] = s_run_time;
+      s_fdr_pending[i] = 0;
+    }
+
+    // for encoder / jog data
+    s_enc_pending_mask = 0;
+    s_jog_pending = 0;
+    s_jog_last = s_run_time - ENCACCELGAP;
+    for (int i = 0; i < 24; i++)
+    {
+      s_enc_pending[i] = 0;
+      s_enc_last[i] = s_jog_last;
+    }
+
+    // midi output frame
+    s_out_len = 0;
+    for (int i = 0; i < 448; i++) s_out_slots[i] = -1;
+    s_out_msgs = 0;
+    s_out_dropped = 0;
+    s_out_bytes = 0;
 
     // for myblink
     s_myblink = false;
     myblink_ctr = 0;
+    s_blink_dots = 0;
+    for (int row = 0; row < 4; row++) s_blink_btns[row] = 0;
+    s_poll_ctr = 0;
 
     // for init
     s_initdone = false;
     s_exitdone = false;
   
-    // touchstates & cache
+    // touchstates
     s_touch_fdr = 0;
-  
-    for (char i = 0; i < 25; i++) 
+    for (int i = 0; i < 24; i++) s_touch_enc[i] = 0;
+
+    s_meter_last = timeGetTime() - METERINTV;
+    s_meter_next = s_meter_last + METERINTV;
+    for (char i = 0; i < 24; i++) Utl_ResetMeter(i);
+    s_sampler = (METERSAMPLE > 0) ? new Mtr_Sampler(METERSAMPLE) : NULL;
+
+    // scheduler
+    s_sched_tokens = OUTRATE * SCHEDBURST;
+    s_sched_last = timeGetTime();
+    s_sched_moved = 0;
+    s_sched_next = 0;
+    for (int i = 0; i < 25; i++)
     {
-      cache_faders[i] = 0;
-      if (i < 24) 
-      {
-        s_touch_enc[i] = 0;
-        cache_enc[i] = 0;
-      }
+      s_sched_age[0][i] = 0;
+      s_sched_age[1][i] = 0;
+      s_sched_age[2][i] = 0;
     }
-  
-    cache_upd_faders = 0;
-    cache_upd_enc = 0;
-    cache_exec = 0;
     master_sel = false;
 
 
     // general states
     s_ch_offset = 0; // bank up/down
+    for (int i = 0; i < 25; i++) s_bank_tks[i] = NULL;
+    for (int i = 0; i < BANKHASHSIZE; i++) s_bank_hash_tks[i] = NULL;
+    for (int i = 0; i < 25; i++) s_aux_count[i] = 0;
+    s_aux_indexed = 0;
+    s_aux_buses_valid = false;
+    s_names_valid = 0;
+    for (int i = 0; i < 25; i++)
+    {
+      s_chs[i].tk = NULL;
+      s_chs[i].tk_num = 0;
+      s_chs[i].color = 0;
+      s_chs[i].sel = s_chs[i].solo = s_chs[i].mute = false;
+      s_chs[i].fxen = s_chs[i].phase = s_chs[i].recarm = false;
+    }
+    s_chs_poll = 0x1ffffff;
+    s_upd_fdr = 0;
+    s_upd_enc = 0;
+    s_upd_elem = 0;
+    s_upd_stp = 0;
+    s_upd_clrsolo = false;
+    s_bank_project = NULL;
     s_play = false; // playstates
     s_rec = false;
     s_loop = false;
@@ -2558,8 +3228,11 @@ public:
     // for channel strip
     chan_ch = 0;
     chan_fx = 0;
+    chan_fx_count = -1;
     chan_par_offs = 0;
     chan_fx_env_arm = false;
+    chan_fx_changed = false;
+    chan_fx_opened = -1;
 
     // save selection
     saved_sel = 0;
@@ -2605,7 +3278,11 @@ public:
 
     // create midi hardware access
     m_midiin = m_midi_in_dev >= 0 ? CreateMIDIInput(m_midi_in_dev) : NULL;
+#if OUTQUEUE
+    m_midiout = m_midi_out_dev >= 0 ? Out_CreateQueue( CreateMIDIOutput(m_midi_out_dev, false, NULL), OUTRATE ) : NULL;
+#else
     m_midiout = m_midi_out_dev >= 0 ? CreateThreadedMIDIOutput( CreateMIDIOutput(m_midi_out_dev, false, NULL) ) : NULL;
+#endif
 
     if (errStats)
     {
@@ -2613,6 +3290,8 @@ public:
       if (m_midi_out_dev >=0  && !m_midiout) *errStats|=2;
     }
 
+    Utl_UpdateBankCache();
+
     if (m_midiin) m_midiin->start();
   } // CSurf_US2400()
 
@@ -2626,6 +3305,7 @@ public:
     
     delete saved_sel;
 
+    delete s_sampler;
     delete m_midiout;
     delete m_midiin;
   } // ~CSurf_US2400()
@@ -2679,11 +3359,11 @@ public:
     for (char ch_id = 0; ch_id <= 24; ch_id++)
     {
       // reset faders
-      MIDIOut(0xb0, ch_id + 0x1f, 0);
-      MIDIOut(0xb0, ch_id, 0);
+      MIDIOutCtl<PRT_FDRLSB>(ch_id, 0);
+      MIDIOutCtl<PRT_FDRMSB>(ch_id, 0);
 
       // reset encoders
-      if (ch_id < 24) MIDIOut(0xb0, ch_id + 0x40, 0);
+      if (ch_id < 24) MIDIOutCtl<PRT_ENC>(ch_id, 0);
     }
 
     // reset mute/solo/select
@@ -2691,7 +3371,14 @@ public:
       MIDIOut(0xb1, btn_id, 0);
 
     // reset bank leds
-    MIDIOut(0xb0, 0x5d, 0);
+    MIDIOutCtl<PRT_BANKLED>(0, 0);
+
+    MIDIOut_Flush();
+
+#ifdef _DEBUG
+    sprintf(debug, "US-2400: sent %ld/%ld msgs, %ld bytes\n", s_out_msgs - s_out_dropped, s_out_msgs, s_out_bytes);
+    DBGS(debug);
+#endif
 
     Stp_CloseWindow();
 
@@ -2701,26 +3388,37 @@ public:
 
   void MySetSurface_UpdateButton(unsigned char btn_id, bool btn_state, bool blink)
   {
-	//button cache
-	if ((button_states[btn_id][0] == btn_state) && (button_states[btn_id][1] == blink)) {
-		return;
-	}
-	else {
-		button_states[btn_id][0] = btn_state; 
-		button_states[btn_id][1] = blink;
-		unsigned char btn_cmd = 0x7f; // on
-		if (blink) btn_cmd = 0x01; // blink
-		if (!btn_state) btn_cmd = 0x00; // off
-		MIDIOut(0xb1, btn_id, btn_cmd);
-	}
+    // sent with the frame, if the led shows something else
+    int btn_cmd = 0x7f; // on
+    if (blink) btn_cmd = 0x01; // blink
+    if (!btn_state) btn_cmd = 0x00; // off
 
+    btn_id = btn_id & 0x7f;
+    s_blink_btns[btn_id >> 5] = s_blink_btns[btn_id >> 5] & (~(1UL << (btn_id & 31)));
+    s_fb.Fb_SetButton(btn_id, btn_cmd);
   } // MySetSurface_UpdateButton
 
 
+  void MySetSurface_UpdateBlinkButton(unsigned char btn_id, bool base_state, bool blink)
+  {
+    // blink over a base state: off leds blink in hardware, lit ones go dark
+    // in Run()'s short blink phase, so the base state stays visible
+    if ( (!blink) || (!base_state) )
+    {
+      MySetSurface_UpdateButton(btn_id, blink, blink);
+      return;
+    }
+
+    btn_id = btn_id & 0x7f;
+    s_blink_btns[btn_id >> 5] = s_blink_btns[btn_id >> 5] | (1UL << (btn_id & 31));
+    s_fb.Fb_SetButton(btn_id, s_myblink ? 0x00 : 0x7f);
+  } // MySetSurface_UpdateBlinkButton
+
+
   void MySetSurface_UpdateBankLEDs()
   {
     char led_id = s_ch_offset / 24;
-    MIDIOut(0xb0, 0x5d, led_id);
+    s_fb.Fb_Set(FB_BANK, 0, led_id);
   } // MySetSurface_UpdateBankLEDs
 
 
@@ -2730,11 +3428,11 @@ public:
     for (char btn_id = 0; btn_id <= 3; btn_id ++)
     {
       bool on = false;
+      bool blink = ((s_automode & (1 << btn_id)) > 0);
 
       if ( (btn_id == 3) && (s_play) ) on = true;
-      if ( (s_automode & (1 << btn_id)) && (s_myblink) ) on = !on;
 
-      MySetSurface_UpdateButton(0x75 + btn_id, on, false);
+      MySetSurface_UpdateBlinkButton(0x75 + btn_id, on, blink);
     }
   } // MySetSurface_UpdateAutoLEDs
 
@@ -2786,7 +3484,7 @@ public:
     int para_amount;
 
     double d_value;
-    int value;
+    int value = 0; // no send: down
     
     bool istrack = false;
     bool ismaster = false;
@@ -2794,7 +3492,7 @@ public:
 
     // is track or master?
     if ( (ch_id >= 0) && (ch_id <= 23) ) istrack = true; // no track fader
-    else if (rpr_tk == CSurf_TrackFromID(0, false)) ismaster = true;
+    else if (rpr_tk == Cnv_ChannelIDToMediaTrack(24)) ismaster = true;
 
     // active fader? 
     if (!rpr_tk) isactive = false; // no corresponding rpr_tk
@@ -2871,17 +3569,10 @@ public:
           value = Cnv_VolToFader(d_value);
 
         } // if (m_flip), else
-      } // if (!rpr_tk || rpr_tk == CSurf_TrackFromID(0, false)), else
+      } // if (!rpr_tk || rpr_tk == Cnv_ChannelIDToMediaTrack(24)), else
       
-      if (value != cache_faders[ch_id])
-      {
-        // new value to cache (gets executed on next run cycle)
-        cache_faders[ch_id] = value;
-
-        // set upd flag 
-        cache_upd_faders = cache_upd_faders | (1 << ch_id);
-
-      }  
+      // gets sent with the next frame
+      s_fb.Fb_Set(FB_FADER, ch_id, value);
 
     } // if (active or master)
   } // MySetSurface_UpdateFader
@@ -2892,16 +3583,22 @@ public:
     if ((s_touch_fdr & (1 << ch_id)) == 0)
     {
       // send midi
-      MIDIOut(0xb0, ch_id + 0x1f, (cache_faders[ch_id] & 0x7f));
-      MIDIOut(0xb0, ch_id, ((cache_faders[ch_id] >> 7) & 0x7f));
-      
-      // remove update flag
-      cache_upd_faders = cache_upd_faders & (~(1 << ch_id));  
+      int value = s_fb.Fb_Take(FB_FADER, ch_id);
+      MIDIOutCtl<PRT_FDRLSB>(ch_id, (value & 0x7f));
+      MIDIOutCtl<PRT_FDRMSB>(ch_id, ((value >> 7) & 0x7f));
+
+      s_sched_moved = s_sched_moved & (~(1 << ch_id));
     }
   } // MySetSurface_ExecuteFaderUpdate
 
 
   void MySetSurface_UpdateEncoder(int ch_id)
+  {
+    (this->*p_update_enc)(ch_id);
+  } // MySetSurface_UpdateEncoder
+
+
+  template <bool meter> void MySetSurface_UpdateEncoder(int ch_id)
   {
     // encoder exists?
     if ( (ch_id >= 0) && (ch_id <= 23) )
@@ -2911,7 +3608,7 @@ public:
       int para_amount;
 
       double d_value;
-      unsigned char value;
+      unsigned char value = 0; // no send: off
       bool dot = false; // for phase switch, rec arm
 
       bool istrack = true;
@@ -2940,8 +3637,7 @@ public:
         if (send_id != -1) 
         {
           isactive = true;
-          int* send_mode = (int*)GetSetTrackSendInfo(rpr_tk, 0, send_id, "I_SENDMODE", NULL);
-          if (*send_mode > 0) ispre = true;
+          ispre = Cnv_AuxIDIsPre(ch_id, m_aux);
         }
       }
 
@@ -2964,14 +3660,14 @@ public:
             {
               GetTrackSendUIVolPan(rpr_tk, send_id, NULL, &d_value);
               value = Cnv_PanToEncoder(d_value);
-              if (METERMODE) value += 0x10; // pan mode
+              if (meter) value += 0x10; // pan mode
             }
           } else
           { // flip -> volume
 
             GetTrackUIVolPan(rpr_tk, &d_value, NULL);
             value = Cnv_VolToEncoder(d_value);
-            if (METERMODE) value += 0x20; // bar mode
+            if (meter) value += 0x20; // bar mode
           }
         } else
         {
@@ -2982,7 +3678,7 @@ public:
             d_value = TrackFX_GetParam(chan_rpr_tk, chan_fx, chan_par_offs + ch_id, &min, &max);
 
             value = Cnv_FXParamToEncoder(min, max, d_value);
-            if (METERMODE) value += 0x20; // bar mode
+            if (meter) value += 0x20; // bar mode
          
           } else if (m_aux > 0)
           { // aux -> send level
@@ -2991,7 +3687,7 @@ public:
             {
               GetTrackSendUIVolPan(rpr_tk, send_id, &d_value, NULL);
               value = Cnv_VolToEncoder(d_value);
-              if (METERMODE) value += 0x20; // bar mode;
+              if (meter) value += 0x20; // bar mode;
             }
           
           } else if (m_pan)
@@ -3000,7 +3696,7 @@ public:
             { // pan mode + fkey -> width
               
               d_value = GetMediaTrackInfo_Value(rpr_tk, "D_WIDTH");
-              if (!METERMODE) 
+              if (!meter)
               {
                 value = Cnv_PanToEncoder(d_value);
               
@@ -3014,13 +3710,14 @@ public:
 
               GetTrackUIVolPan(rpr_tk, NULL, &d_value);
               value = Cnv_PanToEncoder(d_value);
-              if (METERMODE) value += 0x10; // pan mode
+              if (meter) value += 0x10; // pan mode
             }
           }
         } // if (m_flip), else
          
       } // if !active, else
 
+      bool dot_blink = false;
       if (istrack)
       {
 
@@ -3028,132 +3725,369 @@ public:
         if (m_aux > 0)
         {
           if (isactive) dot = true;
-          if ((ispre) && (s_myblink)) dot = !dot;
+          if (ispre) dot_blink = true;
 
         // other modes: phase / rec arm
         } else
         {
           // phase states
-          if ( (bool)GetMediaTrackInfo_Value(rpr_tk, "B_PHASE") ) dot = true;
-          
+          if (s_chs[ch_id].phase) dot = true;
+
           // rec arms: blink
-          if ( ((bool)GetMediaTrackInfo_Value(rpr_tk, "I_RECARM")) && (s_myblink) ) dot = !dot;
+          if (s_chs[ch_id].recarm) dot_blink = true;
         }
 
+        // current blink phase, Run() flips it from here on
+        if ( (dot_blink) && (s_myblink) ) dot = !dot;
+
         if (dot) value += 0x40; // set dot
       }
 
-      if (value != cache_enc[ch_id])
-      {
-        // new value to cache (gets executed on next run cycle)
-        cache_enc[ch_id] = value;
+      if (dot_blink) s_blink_dots = s_blink_dots | (1 << ch_id);
+      else s_blink_dots = s_blink_dots & (~(1 << ch_id));
 
-        // set upd flag 
-        cache_upd_enc = cache_upd_enc | (1 << ch_id);
-      }    
+      // gets sent with the next frame
+      s_fb.Fb_Set(FB_ENC, ch_id, value);
     } // if exists
-  } // MySetSurface_UpdateEncoder
+  } // MySetSurface_UpdateEncoder<meter>
 
 
-  void MySetSurface_ExecuteEncoderUpdate(int ch_id)
+  template <bool meter> void MySetSurface_ExecuteEncoderUpdate(int ch_id)
   {
-    unsigned char out = cache_enc[ch_id];
-    
+    unsigned char out = s_fb.Fb_Take(FB_ENC, ch_id);
+
     // send midi -> pan
-    MIDIOut(0xb0, ch_id + 0x40, cache_enc[ch_id]);
+    MIDIOutCtl<PRT_ENC>(ch_id, out);
 
-    // send midi -> meter mode
-    if (!METERMODE) 
+    // send midi -> m-key mode: rings show the value
+    if (!meter)
     {
-      if (out & 0x40) MIDIOut(0xb0, ch_id + 0x60, 0x60);
-      MIDIOut(0xb0, ch_id + 0x60, cache_enc[ch_id] + 0x50);
+      if (out & 0x40) MIDIOutCtl<PRT_RING>(ch_id, 0x60);
+      MIDIOutCtl<PRT_RING>(ch_id, (out & 0x3f) + 0x50); // dot 0x40 is not part of the value
     }
-    
-    // remove update flag
-    cache_upd_enc = cache_upd_enc & (~(1 << ch_id));
-  } // MySetSurface_ExecuteEncoderUpdate
+  } // MySetSurface_ExecuteEncoderUpdate<meter>
 
 
   void MySetSurface_OutputMeters(bool reset)
   {
     MediaTrack* tk;
-    double tk_peak_l, tk_peak_r, tk_hold;
+    double tk_peak_l, tk_peak_r;
     int peak_out, hold_out;
 
-    // iterate through channels
+    // a frame every METERINTV ms, reset (meter button) right away; a Run()
+    // up to half an interval early (timer jitter) still gets its frame, the
+    // schedule advances by METERINTV so the rate holds, far behind starts over
+    DWORD now = timeGetTime();
+    if ( (!reset) && ((int)(s_meter_next - now) > METERINTV / 2) ) return;
+
+    s_meter_next += METERINTV;
+    if ( (reset) || ((int)(now - s_meter_next) >= 0) ) s_meter_next = now + METERINTV;
+
+    int dt = (int)(now - s_meter_last);
+    if (dt > 1000) dt = 1000;
+    s_meter_last = now;
+
+    // get data, off bank / muted: nothing to read, the meter falls
+    double peaks[24];
+    int levels[24];
+    unsigned long overs = 0;
+
     for(int ch = 0; ch < 24; ch++)
     {
-      // get data
+      peaks[ch] = 0.0;
       tk = Cnv_ChannelIDToMediaTrack(ch);
-      
-      tk_peak_l = Track_GetPeakInfo(tk, 0);
-      tk_peak_r = Track_GetPeakInfo(tk, 1);
 
-      peak_out = Cnv_PeakToEncoder((tk_peak_l + tk_peak_r) / 2);
-      
-      tk_hold = (Track_GetPeakHoldDB(tk, 0, reset) + Track_GetPeakHoldDB(tk, 1, reset)) * 50;
-      hold_out = Cnv_DBToEncoder(tk_hold) + 0x10;
+      if (s_sampler)
+      {
+        // maximum the sampler saw since the last frame
+        double peak = 0.0;
+        bool over = false;
+        if ( (s_sampler->Mtr_Collect(ch, &peak, &over)) && (tk) && (!s_chs[ch].mute) )
+        {
+          peaks[ch] = peak;
+          if (over) overs = overs | (1 << ch);
+        }
 
-      // over
-      if ((tk_peak_l > 1.0) || (tk_peak_r > 1.0)) peak_out += 0x60;
-      else peak_out += 0x40;
-      
-      if (hold_out != cache_meters[ch])
+      } else if ( (tk) && (!s_chs[ch].mute) )
       {
-        // new value to cache (gets executed on next run cycle)
-        cache_meters[ch] = hold_out;
-
-        // set upd flag 
-        cache_upd_meters = cache_upd_meters | (1 << ch);
-      }  
-      // midi out
-      MIDIOut(0xb0, ch + 0x60, peak_out);
+        tk_peak_l = Track_GetPeakInfo(tk, 0);
+        tk_peak_r = Track_GetPeakInfo(tk, 1);
+
+        peaks[ch] = (tk_peak_l + tk_peak_r) / 2;
+        if ((tk_peak_l > 1.0) || (tk_peak_r > 1.0)) overs = overs | (1 << ch);
+      }
+    }
+
+    // all channels in one go
+    Tpr_PeaksToLevels(peaks, levels, 24);
+
+    // iterate through channels
+    for(int ch = 0; ch < 24; ch++)
+    {
+      MeterState* mtr = &s_meters[ch];
+      int level = levels[ch] << 4;
+      bool over = ((overs & (1 << ch)) > 0);
+
+      if (reset)
+      {
+        mtr->hold = 0;
+        mtr->over = false;
+      }
+
+      level = Utl_MeterBallistics(mtr, level, over, dt, now);
+
+      // steps: (level + 8) / 16 in the taper's 1/16 levels
+      peak_out = ((level + 128) >> 8) + (mtr->over ? 0x60 : 0x40);
+      hold_out = ((mtr->hold + 128) >> 8) + 0x10;
+      
+      // only what the ring shows differently gets sent
+      s_fb.Fb_Set(FB_HOLD, ch, hold_out);
+      s_fb.Fb_Set(FB_PEAK, ch, peak_out);
     }
   } // MySetSurface_OutputMeters
 
 
-  void MySetSurface_ExecuteMeterUpdate(char ch_id)
+  int Utl_MeterBallistics(MeterState* mtr, int in, bool over, int dt, DWORD now)
+  {
+    // fixed point, 1/256 steps; returns the level to show
+    const int fall = (int)(METERRELEASE * 15.0 * 256.0 / -MINUSINF); // per s
+
+    // peak: instant attack, linear release
+    mtr->peak = mtr->peak - fall * dt / 1000;
+    if (mtr->peak < in) mtr->peak = in;
+
+    // vu: first order lag
+#if METERVU > 0
+    if (dt >= METERVU) mtr->vu = in;
+    else mtr->vu = mtr->vu + (in - mtr->vu) * dt / METERVU;
+
+    int level = mtr->vu;
+#else
+    mtr->vu = in;
+    int level = mtr->peak;
+#endif
+
+    // hold: highest level, for METERHOLD ms
+    if (level >= mtr->hold)
+    {
+      mtr->hold = level;
+      mtr->hold_time = now;
+
+    } else if ( (METERHOLD > 0) && (now - mtr->hold_time > METERHOLD) )
+    {
+      mtr->hold = level;
+      mtr->hold_time = now;
+    }
+
+    // over led latches for METEROVER ms
+    if (over)
+    {
+      mtr->over = true;
+      mtr->over_time = now;
+
+    } else if ( (METEROVER > 0) && (now - mtr->over_time > METEROVER) )
+    {
+      mtr->over = false;
+    }
+
+    return level;
+  } // Utl_MeterBallistics
+
+
+  void Utl_ResetMeter(int ch_id)
+  {
+    MeterState* mtr = &s_meters[ch_id];
+    mtr->peak = 0;
+    mtr->vu = 0;
+    mtr->hold = 0;
+    mtr->hold_time = 0;
+    mtr->over_time = 0;
+    mtr->over = false;
+  } // Utl_ResetMeter
+
+
+  void Utl_SelectMeterMode(bool meter)
+  {
+    // the instances below test the mode at compile time
+    m_meter = meter;
+    hlp_meter = meter;
+
+    if (meter)
+    {
+      p_update_enc = &CSurf_US2400::MySetSurface_UpdateEncoder<true>;
+      p_on_meter = &CSurf_US2400::OnMeter<true>;
+      p_run = &CSurf_US2400::Run<true>;
+
+    } else
+    {
+      p_update_enc = &CSurf_US2400::MySetSurface_UpdateEncoder<false>;
+      p_on_meter = &CSurf_US2400::OnMeter<false>;
+      p_run = &CSurf_US2400::Run<false>;
+    }
+  } // Utl_SelectMeterMode
+
+
+  void MySetSurface_ToggleMeterMode()
   {
-    MIDIOut(0xb0, ch_id + 0x60, cache_meters[ch_id]);
+    Utl_SelectMeterMode(!m_meter);
+
+    // leave m-key
+    q_mkey = false;
+    s_mkey_on = 0;
+    hlp_qkey = 0;
+    Hlp_Update();
+
+    MySetSurface_UpdateAuxButtons();
+    MySetSurface_UpdateAutoLEDs();
+    MySetSurface_UpdateButton(0x6e, false, false); // null
+    MySetSurface_UpdateButton(0x6b, false, false); // meter
+
+    // the rings show something else now: everything anew,
+    // meters start over (m-key mode doesn't send them)
+    s_fb.Fb_Resync();
+    for (char ch = 0; ch < 24; ch++)
+    {
+      Utl_ResetMeter(ch);
+      MySetSurface_UpdateEncoder(ch);
+    }
+  } // MySetSurface_ToggleMeterMode
+
 
-    // remove update flag
-    cache_upd_meters = cache_upd_meters & (~(1 << ch_id));
+  void MySetSurface_ExecuteMeterUpdate(char ch_id)
+  {
+    if ((s_fb.Fb_Dirty(FB_HOLD) & (1 << ch_id)) > 0) MIDIOutCtl<PRT_RING>(ch_id, s_fb.Fb_Take(FB_HOLD, ch_id));
+    if ((s_fb.Fb_Dirty(FB_PEAK) & (1 << ch_id)) > 0) MIDIOutCtl<PRT_RING>(ch_id, s_fb.Fb_Take(FB_PEAK, ch_id));
   } // MySetSurface_ExecuteMeterUpdate
 
 
-  void MySetSurface_UpdateTrackElement(char ch_id)
+  template <bool meter> void MySetSurface_FlushFrame()
   {
-    // get info
-    MediaTrack* rpr_tk = Cnv_ChannelIDToMediaTrack(ch_id);
-    
-    // if trreck exists
-    if (rpr_tk)
+    // Send what the framebuffer has dirty. Leds first, all of them: few
+    // and short. Then fader / encoder / meter updates within the link's
+    // budget (OUTRATE bytes/s, MIDIOut_Flush charges what actually went out).
+    // Priorities: channels being worked on 0, motors 1, rings 2, meters 3;
+    // every SCHEDAGE cycles an update waits moves it up one, so nothing
+    // starves and a bank switch is out after a few cycles.
+    for (int row = FB_BANK; row < FB_ROWS; row++)
     {
-      bool selected = IsTrackSelected(rpr_tk);
-      bool solo = (bool)GetMediaTrackInfo_Value(rpr_tk, "I_SOLO");
-      bool mute = (bool)GetMediaTrackInfo_Value(rpr_tk, "B_MUTE");
-      bool bypass = (bool)GetMediaTrackInfo_Value(rpr_tk, "I_FXEN");
+      unsigned long dirty = s_fb.Fb_Dirty(row);
+      while (dirty != 0)
+      {
+        int el = Fb_Frame::Fb_Ctz(dirty);
+        dirty = dirty & (dirty - 1);
+
+        int value = s_fb.Fb_Take(row, el);
+        if (row == FB_BANK) MIDIOutCtl<PRT_BANKLED>(0, value);
+        else MIDIOut(0xb1, (row - FB_BTN) * 32 + el, value);
+      }
+    }
+
+    DWORD now = timeGetTime();
+    s_sched_tokens += (long)(now - s_sched_last) * OUTRATE;
+    if (s_sched_tokens > OUTRATE * SCHEDBURST) s_sched_tokens = OUTRATE * SCHEDBURST;
+    s_sched_last = now;
+
+    long budget = s_sched_tokens / 1000;
+
+    // touched faders wait for release
+    unsigned long pending[3] = { s_fb.Fb_Dirty(FB_FADER) & (~s_touch_fdr), s_fb.Fb_Dirty(FB_ENC), s_fb.Fb_Dirty(FB_HOLD) | s_fb.Fb_Dirty(FB_PEAK) };
+    if (!meter) pending[2] = 0;
+
+    unsigned long hot = s_sched_moved;
+    for (int ch = 0; ch < 24; ch++)
+      if (s_touch_enc[ch] > 0) hot = hot | (1 << ch);
+
+    for (int prio = 0; (prio < 4) && (budget > 0); prio++)
+    {
+      // round robin within a priority: channels with something
+      // pending, rotated to start at s_sched_next
+      unsigned long chs = pending[0] | pending[1] | pending[2];
+      unsigned long order = ((chs >> s_sched_next) | (chs << (25 - s_sched_next))) & 0x1ffffff;
+
+      while ( (order != 0) && (budget > 0) )
+      {
+        int ch = (Fb_Frame::Fb_Ctz(order) + s_sched_next) % 25;
+        order = order & (order - 1);
+
+        for (int kind = 0; (kind < 3) && (budget > 0); kind++)
+        {
+          if ((pending[kind] & (1 << ch)) == 0) continue;
+
+          int p = ((hot & (1 << ch)) > 0) ? 0 : kind + 1;
+          p = p - s_sched_age[kind][ch] / SCHEDAGE;
+          if (p < 0) p = 0;
+          if (p != prio) continue;
+
+          // bytes, running status
+          int cost = 2;
+          if (kind == 0) cost = 4;
+          else if ( (kind == 1) && (!meter) ) cost = 6;
+          else if ( (kind == 2) && ((s_fb.Fb_Dirty(FB_HOLD) & s_fb.Fb_Dirty(FB_PEAK) & (1 << ch)) > 0) ) cost = 4;
+
+          // no overtaking: wait for the budget
+          if (cost > budget)
+          {
+            budget = 0;
+            break;
+          }
+
+          if (kind == 0) MySetSurface_ExecuteFaderUpdate(ch);
+          else if (kind == 1) MySetSurface_ExecuteEncoderUpdate<meter>(ch);
+          else MySetSurface_ExecuteMeterUpdate(ch);
+
+          pending[kind] = pending[kind] & (~(1 << ch));
+          s_sched_age[kind][ch] = 0;
+          budget -= cost;
+        }
+      }
+    }
+
+    // what's left waits another cycle
+    for (int kind = 0; kind < 3; kind++)
+      for (int ch = 0; ch < 25; ch++)
+        if ( ((pending[kind] & (1 << ch)) > 0) && (s_sched_age[kind][ch] < 255) ) s_sched_age[kind][ch]++;
+
+    s_sched_next++;
+    if (s_sched_next > 24) s_sched_next = 0;
+  } // MySetSurface_FlushFrame<meter>
+
 
+  void MySetSurface_UpdateTrackElement(int ch_id)
+  {
+    // get info
+    ChannelState* chs = &s_chs[ch_id];
+
+    // if track exists
+    if (chs->tk)
+    {
       // blink chan sel
-      selected = ( (m_chan && ch_id == chan_ch && s_myblink) != selected );
+      bool sel_blink = (m_chan && ch_id == chan_ch);
 
       // blink track fx bypass
-      mute = ( (!bypass && s_myblink) != mute );
+      bool mute_blink = !chs->fxen;
+
+      MySetSurface_UpdateBlinkButton(Prt_Out<PRT_SEL>::CC(ch_id), chs->sel, sel_blink);
+      MySetSurface_UpdateButton(Prt_Out<PRT_SOLO>::CC(ch_id), chs->solo, false);
+      MySetSurface_UpdateBlinkButton(Prt_Out<PRT_MUTE>::CC(ch_id), chs->mute, mute_blink);
 
-      MySetSurface_UpdateButton(ch_id * 4 + 1, selected, false);
-      MySetSurface_UpdateButton(ch_id * 4 + 2, solo, false);
-      MySetSurface_UpdateButton(ch_id * 4 + 3, mute, false);
-      
     } else
     {
       // reset buttons
-      MySetSurface_UpdateButton(ch_id * 4 + 1, false, false);
-      MySetSurface_UpdateButton(ch_id * 4 + 2, false, false);
-      MySetSurface_UpdateButton(ch_id * 4 + 3, false, false);
+      MySetSurface_UpdateButton(Prt_Out<PRT_SEL>::CC(ch_id), false, false);
+      MySetSurface_UpdateButton(Prt_Out<PRT_SOLO>::CC(ch_id), false, false);
+      MySetSurface_UpdateButton(Prt_Out<PRT_MUTE>::CC(ch_id), false, false);
     }
   } // MySetSurface_UpdateTrackElement
 
 
+  void MySetSurface_UpdateMasterSel()
+  {
+    // blink Master if anything selected, over its own selection
+    bool any = ( (CountSelectedTracks(0) > 0) || s_chs[24].sel );
+    MySetSurface_UpdateBlinkButton(Prt_Out<PRT_MASTERSEL>::cc, s_chs[24].sel, any);
+  } // MySetSurface_UpdateMasterSel
+
+
   void MySetSurface_ToggleFlip()
   {
     m_flip = !m_flip;
@@ -3215,16 +4149,8 @@ public:
     // check parameter count
     int amount_paras = TrackFX_GetNumParams(chan_rpr_tk, chan_fx);
     if (chan_par_offs >= amount_paras) chan_par_offs -= 24;
-    
-    // update encoders or faders and scribble strip
-    for (char ch_id = 0; ch_id <= 23; ch_id++) 
-    {
-      if (m_flip) MySetSurface_UpdateFader(ch_id);
-      else MySetSurface_UpdateEncoder(ch_id);
-
-      if (stp_hwnd != NULL) Stp_Update(ch_id);
-    }
 
+    Utl_UpdateChanParams();
   } // MySetSurface_Chan_Set_FXParamOffset
 
 
@@ -3233,8 +4159,8 @@ public:
     if ( (ch_id != chan_ch) || (force_upd) )
     {
       // reset button of old channel
-      if (IsTrackSelected(chan_rpr_tk)) MySetSurface_UpdateButton(chan_ch * 4 + 1, true, false);
-      else MySetSurface_UpdateButton(chan_ch * 4 + 1, false, false);
+      if (IsTrackSelected(chan_rpr_tk)) MySetSurface_UpdateButton(Prt_Out<PRT_SEL>::CC(chan_ch), true, false);
+      else MySetSurface_UpdateButton(Prt_Out<PRT_SEL>::CC(chan_ch), false, false);
 
       // close fx of old channel
       MyCSurf_Chan_CloseFX(chan_fx);
@@ -3243,8 +4169,9 @@ public:
       MediaTrack* rpr_tk = Cnv_ChannelIDToMediaTrack(ch_id);
       chan_ch = ch_id;
       chan_rpr_tk = rpr_tk;
+      chan_fx_changed = true; // its fx count, on next Run()
       
-      MySetSurface_UpdateButton(chan_ch * 4 + 1, true, true);
+      MySetSurface_UpdateTrackElement(chan_ch); // blink select
 
       // open fx              
       MyCSurf_Chan_OpenFX(chan_fx);
@@ -3276,6 +4203,9 @@ public:
     if (s_ch_offset > 168) s_ch_offset = 168;
     if (s_ch_offset < 0) s_ch_offset = 0;
 
+    Utl_UpdateBankCache();
+    Utl_PollChannels(false);
+
     // update channel strip
     if (m_chan) chan_ch = chan_ch + old_ch_offset - s_ch_offset;
 
@@ -3312,7 +4242,7 @@ public:
     Utl_CheckFXInsert();
     
     // blink Track Select
-    MySetSurface_UpdateButton(chan_ch * 4 + 1, true, true);
+    MySetSurface_UpdateTrackElement(chan_ch);
 
     // blink para offset, bypass
     MySetSurface_UpdateAuxButtons();
@@ -3341,8 +4271,8 @@ public:
     MySetSurface_UpdateButton(0x64, false, false);
 
     // reset select button
-    if (IsTrackSelected(chan_rpr_tk)) MySetSurface_UpdateButton(chan_ch * 4 + 1, true, false);
-    else MySetSurface_UpdateButton(chan_ch * 4 + 1, false, false);
+    if (IsTrackSelected(chan_rpr_tk)) MySetSurface_UpdateButton(Prt_Out<PRT_SEL>::CC(chan_ch), true, false);
+    else MySetSurface_UpdateButton(Prt_Out<PRT_SEL>::CC(chan_ch), false, false);
 
     // if writing fx envs, stop now
     if (chan_fx_env_arm) MyCSurf_Chan_ToggleArmFXEnv();
@@ -3419,6 +4349,21 @@ public:
     m_aux = 0;
   } // MySetSurface_ExitAuxMode
 
+
+  void MySetSurface_UpdateAuxSend(char ch_id, bool pan)
+  {
+    // on next Run(), flip: faders show send levels, encoders pans; else encoders levels
+    if (m_flip)
+    {
+      if (pan) s_upd_enc = s_upd_enc | (1 << ch_id);
+      else s_upd_fdr = s_upd_fdr | (1 << ch_id);
+
+    } else if (!pan)
+    {
+      s_upd_enc = s_upd_enc | (1 << ch_id);
+    }
+  } // MySetSurface_UpdateAuxSend
+
   
 
   // REAPER INITIATED SURFACE UPDATES
@@ -3427,9 +4372,10 @@ public:
   { 
     int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
 
+    // set on next Run()
     if ( (ch_id >= 0) && (ch_id <= 24) )
-      if (!m_flip) MySetSurface_UpdateFader(ch_id);
-      else if (ch_id <= 23) MySetSurface_UpdateEncoder(ch_id);
+      if (!m_flip) s_upd_fdr = s_upd_fdr | (1 << ch_id);
+      else if (ch_id <= 23) s_upd_enc = s_upd_enc | (1 << ch_id);
   } // SetSurfaceVolume
   
 
@@ -3437,14 +4383,22 @@ public:
   {
     int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
 
+    // set on next Run()
     if ( (ch_id >= 0) && (ch_id <= 24) )
-      if (m_flip) MySetSurface_UpdateFader(ch_id);
-      else if (ch_id <= 23) MySetSurface_UpdateEncoder(ch_id);
+      if (m_flip) s_upd_fdr = s_upd_fdr | (1 << ch_id);
+      else if (ch_id <= 23) s_upd_enc = s_upd_enc | (1 << ch_id);
   } // SetSurfacePan
   
 
   void SetTrackListChange()
   {
+    // a new track could have a deleted one's address
+    s_names_valid = 0;
+    s_aux_buses_valid = false;
+
+    Utl_UpdateBankCache();
+    Utl_PollChannels(false);
+
     CSurf_ResetAllCachedVolPanStates(); // is this needed?
 
     // reset faders, encoders, track elements, update scribble strip
@@ -3459,17 +4413,28 @@ public:
   } // SetTrackListChange
 
 
-  void SetSurfaceMute(MediaTrack* rpr_tk, bool mute)
+  void SetTrackTitle(MediaTrack* rpr_tk, const char* title)
   {
+    // aux buses and send names may have changed
+    s_aux_buses_valid = false;
+    s_aux_indexed = 0;
+
     int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
 
-    if ( (ch_id >= 0) && (ch_id <= 23) ) 
+    if ( (ch_id >= 0) && (ch_id <= 23) && (title) )
     {
-      if (mute) MySetSurface_UpdateButton(4 * ch_id + 3, true, false);
-      else MySetSurface_UpdateButton(4 * ch_id + 3, false, false);
-
-      Stp_Update(ch_id);
+      Utl_StoreTrackName(ch_id, title);
+      s_upd_stp = s_upd_stp | (1 << ch_id);
     }
+  } // SetTrackTitle
+
+
+  void SetSurfaceMute(MediaTrack* rpr_tk, bool mute)
+  {
+    int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
+
+    // read on next Run()
+    if ( (ch_id >= 0) && (ch_id <= 23) ) s_chs_poll = s_chs_poll | (1 << ch_id);
   } // SetSurfaceMute
 
 
@@ -3477,12 +4442,9 @@ public:
   {
     int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
 
-    // update buttons
-    if ( (ch_id >= 0) && (ch_id <= 24) ) 
-    {
-      MySetSurface_UpdateButton(4 * ch_id + 1, selected, false);
-      Stp_Update(ch_id);
-    }
+    // read on next Run(), master for its blink
+    if ( (ch_id >= 0) && (ch_id <= 24) ) s_chs_poll = s_chs_poll | (1 << ch_id);
+    s_chs_poll = s_chs_poll | (1 << 24);
   } // SetSurfaceSelected
 
 
@@ -3490,15 +4452,9 @@ public:
   {
     int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
 
-    if ( (ch_id >= 0) && (ch_id <= 23) ) 
-    {
-      if (solo) MySetSurface_UpdateButton(4 * ch_id + 2, true, false);
-      else MySetSurface_UpdateButton(4 * ch_id + 2, false, false);
-    }
-
-    // update CLR SOLO
-    if (AnyTrackSolo(0)) MySetSurface_UpdateButton(0x62, true, true);
-    else MySetSurface_UpdateButton(0x62, false, false);
+    // read on next Run(), CLR SOLO too (any track, not only the bank's)
+    if ( (ch_id >= 0) && (ch_id <= 23) ) s_chs_poll = s_chs_poll | (1 << ch_id);
+    s_upd_clrsolo = true;
   } // SetSurfaceSolo
 
 
@@ -3506,11 +4462,8 @@ public:
   {
     int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
 
-    if ((ch_id > 0) && (ch_id < 24))
-    {
-      MySetSurface_UpdateEncoder(ch_id);
-      Stp_Update(ch_id);
-    }
+    // read on next Run()
+    if ( (ch_id >= 0) && (ch_id <= 23) ) s_chs_poll = s_chs_poll | (1 << ch_id);
   } // SetSurfaceRecArm
 
 
@@ -3547,10 +4500,79 @@ public:
     s_loop = rep;
 
     // update in/out buttons
-    MySetSurface_UpdateButton(0x73, s_loop, false); 
+    MySetSurface_UpdateButton(0x73, s_loop, false);
   } // SetRepeatState
 
 
+  int Extended(int call, void* parm1, void* parm2, void* parm3)
+  {
+    MediaTrack* rpr_tk = (MediaTrack*)parm1;
+
+    // only the chan track's fx are shown
+    bool chan_tk = ( (m_chan) && (rpr_tk != NULL) && (rpr_tk == chan_rpr_tk) );
+
+    switch (call)
+    {
+      case CSURF_EXT_SETFXPARAM :
+        // parm2: fx << 16 | param
+        if ( (chan_tk) && (parm2) && (((*(int*)parm2) >> 16) == chan_fx) )
+        {
+          int ch_id = ((*(int*)parm2) & 0xffff) - chan_par_offs;
+          if ( (ch_id >= 0) && (ch_id <= 23) )
+          {
+            // set on next Run()
+            if (m_flip) s_upd_fdr = s_upd_fdr | (1 << ch_id);
+            else s_upd_enc = s_upd_enc | (1 << ch_id);
+            s_upd_stp = s_upd_stp | (1 << ch_id);
+          }
+        }
+        return 1;
+
+      case CSURF_EXT_SETFXENABLED :
+        // aux 3 shows the bypass
+        if ( (chan_tk) && (parm2) && (*(int*)parm2 == chan_fx) ) MySetSurface_UpdateAuxButtons();
+        return 1;
+
+      case CSURF_EXT_SETFXCHANGE :
+        // fx added, deleted or moved: on next Run(), our own fx
+        // actions aren't done yet when this comes
+        if (chan_tk) chan_fx_changed = true;
+        return 1;
+
+      case CSURF_EXT_SETFXOPEN :
+        // parm3: ui opened / closed
+        if ( (chan_tk) && (parm2) && (parm3) ) chan_fx_opened = *(int*)parm2;
+        return 1;
+
+      case CSURF_EXT_SETSENDVOLUME :
+      case CSURF_EXT_SETSENDPAN :
+        // parm2: send index (hardware outputs first, like GetTrackSendUIVolPan),
+        // shown if it's the channel's send to the current aux
+        if ( (m_aux > 0) && (parm2) )
+        {
+          int ch_id = Cnv_MediaTrackToChannelID(rpr_tk);
+          if ( (ch_id >= 0) && (ch_id <= 23) && (Cnv_AuxIDToSendID(ch_id, m_aux) == *(int*)parm2) )
+            MySetSurface_UpdateAuxSend(ch_id, (call == CSURF_EXT_SETSENDPAN));
+        }
+        return 1;
+
+      case CSURF_EXT_SETRECVVOLUME :
+      case CSURF_EXT_SETRECVPAN :
+        // parm2: receive index on the current aux bus, shown on its source's channel
+        if ( (m_aux > 0) && (parm2) && (rpr_tk != NULL) && (rpr_tk == Utl_FindAux(m_aux)) )
+        {
+          MediaTrack* src_tk = (MediaTrack*)GetSetTrackSendInfo(rpr_tk, -1, *(int*)parm2, "P_SRCTRACK", NULL);
+          int ch_id = Cnv_MediaTrackToChannelID(src_tk);
+          if ( (ch_id >= 0) && (ch_id <= 23) )
+            MySetSurface_UpdateAuxSend(ch_id, (call == CSURF_EXT_SETRECVPAN));
+        }
+        return 1;
+    }
+
+    return 0;
+  } // Extended
+
+
 
   ////// SUBMIT CHANGES TO REAPER /////
 
@@ -3639,7 +4661,8 @@ public:
     phase = !phase;
     SetMediaTrackInfo_Value(rpr_tk, "B_PHASE", phase);
 
-    MySetSurface_UpdateEncoder(ch_id);
+    // no callback for phase, read on next pass
+    if ( (ch_id >= 0) && (ch_id <= 23) ) s_chs_poll = s_chs_poll | (1 << ch_id);
   } // MyCSurf_SwitchPhase
 
 
@@ -3687,6 +4710,7 @@ public:
     } 
 
     GetSetObjectState(aux_tk, chunk_wdl.Get());
+    s_aux_indexed = 0;
 
   } // MyCSurf_AddSwitchAuxSend
 
@@ -3709,6 +4733,7 @@ public:
     chunk_wdl = Utl_Chunk_RemoveLine(chunk_wdl, WDL_String(search));
 
     GetSetObjectState(aux_tk, chunk_wdl.Get()); 
+    s_aux_indexed = 0;
   } // MyCSurf_RemoveAuxSend
 
 
@@ -3792,9 +4817,7 @@ public:
     chan_par_offs = 0;
 
     MySetSurface_UpdateAuxButtons();
-
-    for (int enc = 0; enc < 24; enc++)
-      if (stp_hwnd != NULL) Stp_Update(enc);
+    Utl_UpdateChanParams();
 
     // bugfix: deselect master
     if (!master_sel) SetTrackSelected(Cnv_ChannelIDToMediaTrack(24), false); 
@@ -3902,7 +4925,10 @@ public:
     
     // toggle bypass
     bypass = !bypass;
-    CSurf_OnFXChange(rpr_tk, (int)bypass);   
+    CSurf_OnFXChange(rpr_tk, (int)bypass);
+
+    // no callback for fx enable, read on next pass
+    if ( (ch_id >= 0) && (ch_id <= 23) ) s_chs_poll = s_chs_poll | (1 << ch_id);
   } // MyCSurf_Chan_ToggleAllFXBypass
 
 
@@ -4257,23 +5283,23 @@ public:
   } // MyCSurf_RemoveTimeSel
 
 
-  void MyCSurf_Scrub(char rel_value, bool fast)
+  void MyCSurf_Scrub(double rel_value, bool fast)
   {
     double d_value;
-    if (fast) d_value = (double)rel_value / (double)SCRUBRESFAST;
-    else d_value = (double)rel_value / (double)SCRUBRESSLOW;
+    if (fast) d_value = rel_value / (double)SCRUBRESFAST;
+    else d_value = rel_value / (double)SCRUBRESSLOW;
     
     CSurf_ScrubAmt(d_value);
   } // MyCSurf_Scrub
     
 
-  void MyCSurf_MoveEditCursor(char rel_value, bool fast)
+  void MyCSurf_MoveEditCursor(double rel_value, bool fast)
   {
     ReaProject* rpr_pro = EnumProjects(-1, NULL, 0);
     double old_val = GetCursorPosition();
     double d_value;
-    if (fast) d_value = (double)rel_value / (double)MOVERESFAST;
-    else d_value = (double)rel_value / (double)MOVERESSLOW;
+    if (fast) d_value = rel_value / (double)MOVERESFAST;
+    else d_value = rel_value / (double)MOVERESSLOW;
 
     SetEditCurPos2(rpr_pro, old_val + d_value, true, false);
   } // MyCSurf_MoveEditCursor
@@ -4291,6 +5317,7 @@ public:
   const char *GetDescString()
   {
     descspace.Set(DESCSTRING);
+    descspace.Append(m_meter ? " (with VU-Meters)" : " (M-Key Support)");
     char tmp[512];
     sprintf(tmp," (dev %d,%d)",m_midi_in_dev,m_midi_out_dev);
     descspace.Append(tmp);
@@ -4300,7 +5327,7 @@ public:
 
   const char *GetConfigString() // string of configuration data
   {
-    sprintf(configtmp,"0 0 %d %d",m_midi_in_dev,m_midi_out_dev);      
+    sprintf(configtmp,"%d 0 %d %d",m_meter ? 0 : 1,m_midi_in_dev,m_midi_out_dev);      
     return configtmp;
   }
 
@@ -4310,58 +5337,68 @@ public:
 
   void Run()
   {
+    // between cycles, so the resync goes out in the new mode's format
+    if (m_meter_toggle)
+    {
+      m_meter_toggle = false;
+      MySetSurface_ToggleMeterMode();
+    }
+
+    (this->*p_run)();
+  } // Run
+
+
+  template <bool meter> void Run()
+  {
+    // project tab switched?
+    if (EnumProjects(-1, NULL, 0) != s_bank_project) SetTrackListChange();
+
     // midi processing
     if ( (m_midiin) ) //&& (s_initdone) )
     {
-      m_midiin->SwapBufs(timeGetTime());
+      s_run_time = timeGetTime();
+      m_midiin->SwapBufs(s_run_time);
       int l=0;
       MIDI_eventlist *list=m_midiin->GetReadBuf();
       MIDI_event_t *evts;
       while ((evts=list->EnumItems(&l))) MIDIin(evts);
+
+      // apply coalesced fader / encoder / jog moves
+      MIDIin_Flush();
     }
 
+    // catch up on anything REAPER didn't tell
+    // (fx params and sends come with Extended)
+    if (s_poll_ctr > MYPOLLINTV)
+    {
+      s_poll_ctr = 0;
+      s_chs_poll = 0x1ffffff;
+      Utl_PollChannels(true);
+      Utl_CheckAuxSends();
 
-    // countdown enc touch delay
-    for (char i = 0; i < 24; i++)
-      if (s_touch_enc[i] > 0) s_touch_enc[i]--;
+    } else
+    {
+      s_poll_ctr++;
+    }
 
+    // track states that changed since last cycle
+    if (s_chs_poll != 0) Utl_PollChannels(true);
 
-    // Execute fader/encoder updates
-    char i = 0;
-    char ex = 0;
-    do 
-    {
-    
-      if ((cache_upd_faders & (1 << cache_exec)) > 0) {
-        MySetSurface_ExecuteFaderUpdate(cache_exec);
-        ex += 2;
-      }
-      if ((cache_upd_enc & (1 << cache_exec)) > 0) {
-        MySetSurface_ExecuteEncoderUpdate(cache_exec);
-        ex++;
-      }
+    // everything flagged since last cycle
+    Utl_UpdateChannels();
 
-      if (METERMODE && ((cache_upd_meters & (1 << cache_exec)) > 0)) {
-        MySetSurface_ExecuteMeterUpdate(cache_exec);
-        ex++;
-      }
-           
-      // incr / wrap cache_exec
-      cache_exec++;
-      if (cache_exec > 24) cache_exec = 0;
 
-      i++;
-      
-      // repeat loop until all channels checked or exlimit reached
-    } while ((i < 25) && (ex < EXLIMIT));
+    // countdown enc touch delay
+    for (int i = 0; i < 24; i++)
+      if (s_touch_enc[i] > 0) s_touch_enc[i]--;
 
 
     // meters
-    if (METERMODE) MySetSurface_OutputMeters(false); // false = no reset
+    if (meter) MySetSurface_OutputMeters(false); // false = no reset
 
 
     // countdown m button delay, update if applicable
-    if (q_mkey)
+    if ( (!meter) && (q_mkey) )
     {
       if (s_mkey_on > 0) {
         s_mkey_on--;
@@ -4370,14 +5407,14 @@ public:
         bool mblnk = false;
         if (s_mkey_on % 2 == 0) mblnk = true;
         
-        char mde = 0;
+        int mde = 0;
         if (m_chan) mde = 1;
         if (m_aux > 0) mde = 2;
 
         bool mact = false;
         
         // aux buttons / transport
-        for (char b = 0; b < 6; b++)
+        for (int b = 0; b < 6; b++)
         {
           if (cmd_ids[3][mde][b] != -1)
           {
@@ -4426,23 +5463,26 @@ public:
       if (s_myblink) myblink_ctr = MYBLINKINTV - MYBLINKRATIO;
       else myblink_ctr = 0;
       
+      // flip encoder dots (rec arm, pre sends) and lit blinking buttons
+      // in their cached values, the others blink in hardware
       for (char ch = 0; ch < 24; ch++)
       {
-        // update encoders (rec arm)
-        MySetSurface_UpdateEncoder(ch);
-
-        // update track buttons
-        MySetSurface_UpdateTrackElement(ch);
-
+        if ((s_blink_dots & (1 << ch)) > 0)
+        {
+          s_fb.Fb_Set(FB_ENC, ch, s_fb.Fb_Get(FB_ENC, ch) ^ 0x40);
+        }
       }
 
-      // blink Master if anything selected
-      MediaTrack* master = Cnv_ChannelIDToMediaTrack(24);
-      bool on = ( ( ( (CountSelectedTracks(0) > 0) || IsTrackSelected(master) ) && s_myblink ) != IsTrackSelected(master) );
-      MySetSurface_UpdateButton(97, on, false);
-
-      // Update automation modes
-      MySetSurface_UpdateAutoLEDs();
+      for (int row = 0; row < 4; row++)
+      {
+        unsigned long mask = s_blink_btns[row];
+        while (mask != 0)
+        {
+          int el = Fb_Frame::Fb_Ctz(mask);
+          mask = mask & (mask - 1);
+          s_fb.Fb_Set(FB_BTN + row, el, s_fb.Fb_Get(FB_BTN + row, el) ^ 0x7f);
+        }
+      }
 
     } else
     {
@@ -4456,7 +5496,7 @@ public:
 
       stp_fdr_touch = s_touch_fdr;
       stp_enc_touch = 0;      
-      for (char ch = 0; ch < 24; ch++)
+      for (int ch = 0; ch < 24; ch++)
       {
         if (m_chan && (s_touch_enc[ch] > 0)) stp_enc_touch = stp_enc_touch | (1 << ch);
        
@@ -4476,11 +5516,8 @@ public:
       }
     }
 
-    // check fx count if chan mode
-    if (m_chan)
-    {
-      Utl_CheckFXInsert();
-    }
+    // chan track's fx changed or opened (see Extended)
+    if (m_chan) Utl_UpdateChanFX();
 
     // init
     if (!s_initdone) 
@@ -4488,7 +5525,11 @@ public:
       s_initdone = MySetSurface_Init();
       if (stp_open == 1) Stp_OpenWindow();
     }
-  } // Run
+
+    // everything this cycle (and callbacks since the last) in one go
+    MySetSurface_FlushFrame<meter>();
+    MIDIOut_Flush();
+  } // Run<meter>
 
 
 
@@ -4524,7 +5565,8 @@ static IReaperControlSurface *createFunc(const char *type_string, const char *co
   int parms[4];
   parseParms(configString,parms);
 
-  return new CSurf_US2400(parms[2],parms[3],errStats);
+  // parms[0]: 0 = meter mode, 1 = m-key mode
+  return new CSurf_US2400(parms[2],parms[3],parms[0] != 1,errStats);
 }
 
 
@@ -4543,6 +5585,8 @@ static WDL_DLGRET dlgProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam)
         ShowWindow(GetDlgItem(hwndDlg,IDC_EDIT2_LBL),SW_HIDE);
         ShowWindow(GetDlgItem(hwndDlg,IDC_EDIT2_LBL2),SW_HIDE);
 
+        if (parms[0] == 1) CheckDlgButton(hwndDlg,IDC_CHECK1,BST_CHECKED);
+
         int n=GetNumMIDIInputs();
         int x=SendDlgItemMessage(hwndDlg,IDC_COMBO2,CB_ADDSTRING,0,(LPARAM)"None");
         SendDlgItemMessage(hwndDlg,IDC_COMBO2,CB_SETITEMDATA,x,-1);
@@ -4582,7 +5626,9 @@ static WDL_DLGRET dlgProc(HWND hwndDlg, UINT uMsg, WPARAM wParam, LPARAM lParam)
         r=SendDlgItemMessage(hwndDlg,IDC_COMBO3,CB_GETCURSEL,0,0);
         if (r != CB_ERR)  outdev = SendDlgItemMessage(hwndDlg,IDC_COMBO3,CB_GETITEMDATA,r,0);
 
-        sprintf(tmp,"0 0 %d %d",indev,outdev);
+        int mkey = (IsDlgButtonChecked(hwndDlg,IDC_CHECK1) == BST_CHECKED) ? 1 : 0;
+
+        sprintf(tmp,"%d 0 %d %d",mkey,indev,outdev);
         lstrcpyn((char *)lParam, tmp,wParam);       
       }
     break;
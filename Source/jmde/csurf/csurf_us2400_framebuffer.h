@@ -0,0 +1,132 @@
+/*
+** reaper_csurf
+** Tascam US-2400 support
+** Surface framebuffer
+*/
+
+#ifndef _CSURF_US2400_FRAMEBUFFER_H_
+#define _CSURF_US2400_FRAMEBUFFER_H_
+
+#include "csurf_us2400_protocol.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+// Everything the surface shows, as wanted and as last sent: leds, faders,
+// encoders (and their rings in m-key mode), meters. Updates only write the
+// wanted value; an element whose wanted value differs from what was sent
+// has its dirty bit set, and the csurf's flush sends exactly those.
+//
+// Rows of 32 elements, one dirty word each, so a row is a channel mask the
+// scheduler can use as it is, and a flush walks set bits with Fb_Ctz
+// instead of testing every element. Fb_Resync marks everything, e.g. after
+// the surface lost its state.
+
+enum Fb_Row
+{
+  FB_FADER = 0, // 25 faders, 14 bit
+  FB_ENC, // 24 encoders (value | dot)
+  FB_HOLD, // 24 meter holds
+  FB_PEAK, // 24 meter peaks
+  FB_BANK, // bank leds, one element
+  FB_BTN, // 128 button leds (0 off, 1 blink, 0x7f on), 4 rows
+
+  FB_ROWS = FB_BTN + 4
+};
+
+#define FB_UNSENT -1 // never equals a wanted value
+
+
+class Fb_Frame
+{
+public:
+  Fb_Frame()
+  {
+    // the surface is cleared on start
+    for (int i = 0; i < FB_ROWS * 32; i++)
+    {
+      m_want[i] = 0;
+      m_sent[i] = 0;
+    }
+
+    for (int row = 0; row < FB_ROWS; row++) m_dirty[row] = 0;
+
+    // what Fb_Resync sends: only elements the surface shows
+    for (int row = 0; row < 4; row++) m_used[FB_BTN + row] = Prt_ButtonLeds(row);
+    m_used[FB_FADER] = 0x1ffffff;
+    m_used[FB_ENC] = 0xffffff;
+    m_used[FB_HOLD] = 0xffffff;
+    m_used[FB_PEAK] = 0xffffff;
+    m_used[FB_BANK] = 0x1;
+  } // Fb_Frame
+
+
+  void Fb_Set(int row, int el, int value)
+  {
+    int i = row * 32 + el;
+    m_want[i] = value;
+
+    // back to what the surface shows: nothing to send
+    if (value != m_sent[i]) m_dirty[row] = m_dirty[row] | (1UL << el);
+    else m_dirty[row] = m_dirty[row] & (~(1UL << el));
+  } // Fb_Set
+
+  void Fb_SetButton(unsigned char btn_id, int value)
+  {
+    Fb_Set(FB_BTN + (btn_id >> 5), btn_id & 31, value);
+  } // Fb_SetButton
+
+  int Fb_Get(int row, int el)
+  {
+    return m_want[row * 32 + el];
+  } // Fb_Get
+
+  unsigned long Fb_Dirty(int row)
+  {
+    return m_dirty[row];
+  } // Fb_Dirty
+
+
+  int Fb_Take(int row, int el)
+  {
+    // the wanted value, counts as sent from here on
+    int i = row * 32 + el;
+    m_sent[i] = m_want[i];
+    m_dirty[row] = m_dirty[row] & (~(1UL << el));
+    return m_want[i];
+  } // Fb_Take
+
+
+  void Fb_Resync()
+  {
+    for (int row = 0; row < FB_ROWS; row++)
+    {
+      for (int el = 0; el < 32; el++) m_sent[row * 32 + el] = FB_UNSENT;
+      m_dirty[row] = m_used[row];
+    }
+  } // Fb_Resync
+
+
+  static int Fb_Ctz(unsigned long mask)
+  {
+    // lowest set bit, mask != 0
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return (int)bit;
+#else
+    return __builtin_ctzl(mask);
+#endif
+  } // Fb_Ctz
+
+
+private:
+  int m_want[FB_ROWS * 32];
+  int m_sent[FB_ROWS * 32];
+  unsigned long m_dirty[FB_ROWS];
+  unsigned long m_used[FB_ROWS];
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+** reaper_csurf
+** Tascam US-2400 support
+** Meter sampling thread
+*/
+
+#ifndef _CSURF_US2400_METERS_H_
+#define _CSURF_US2400_METERS_H_
+
+
+// Reads the 24 channels' peaks on its own thread at 'rate' Hz, so meters
+// don't depend on how often (or late) REAPER calls Run(). Each channel has a
+// ring of the last MTR_RINGSIZE samples; MySetSurface_OutputMeters takes the
+// maximum of what came in since its last frame, so transients between two
+// frames still show.
+//
+// The bank (channel -> MediaTrack*) is published by the main thread with a
+// sequence count (odd while written), the sampler copies it whole or retries.
+// Samples carry the count they were taken with, so after a bank switch
+// nothing of the old tracks reaches the new channels.
+//
+// The sampler only calls Track_GetPeakInfo. A track deleted between
+// REAPER's delete and SetTrackListChange could still be read, so this is off
+// unless METERSAMPLE is set.
+
+#define MTR_RINGSIZE 16 // samples per channel, power of 2
+
+
+class Mtr_Sampler
+{
+public:
+  Mtr_Sampler(int rate)
+  {
+    m_interval = (rate > 0) ? 1000 / rate : 10;
+    if (m_interval < 1) m_interval = 1;
+    m_quit = false;
+
+    m_seq = 0;
+    for (int ch = 0; ch < 24; ch++)
+    {
+      m_tks[ch] = NULL;
+      m_head[ch] = 0;
+      m_read[ch] = 0;
+      for (int i = 0; i < MTR_RINGSIZE; i++)
+      {
+        m_peak[ch][i] = 0.0f;
+        m_tag[ch][i] = -1;
+      }
+    }
+
+    DWORD id;
+    m_thread = CreateThread(NULL, 0, Mtr_SamplerProc, this, 0, &id);
+  } // Mtr_Sampler
+
+  ~Mtr_Sampler()
+  {
+    if (m_thread)
+    {
+      m_quit = true;
+      WaitForSingleObject(m_thread, INFINITE);
+      CloseHandle(m_thread);
+      m_thread = 0;
+    }
+  } // ~Mtr_Sampler
+
+
+  // main thread
+
+  void Mtr_Publish(MediaTrack* const* tks)
+  {
+    // odd count: being written
+    InterlockedIncrement(&m_seq);
+    for (int ch = 0; ch < 24; ch++) m_tks[ch] = tks[ch];
+    InterlockedIncrement(&m_seq);
+  } // Mtr_Publish
+
+  bool Mtr_Collect(int ch, double* peak, bool* over)
+  {
+    // maximum since the last call, false = no sample of the current bank yet
+    LONG seq = m_seq; // only written by this thread
+    DWORD head = (DWORD)InterlockedCompareExchange(&m_head[ch], 0, 0);
+    DWORD from = m_read[ch];
+
+    // nothing new: the latest sample again
+    if (head == from) from = head - 1;
+
+    // only the last MTR_RINGSIZE are still there
+    if (head - from > MTR_RINGSIZE) from = head - MTR_RINGSIZE;
+
+    m_read[ch] = head;
+
+    float max = -1.0f;
+    bool ovr = false;
+
+    for (DWORD i = from; i != head; i++)
+    {
+      LONG tag = m_tag[ch][i & (MTR_RINGSIZE - 1)];
+      if ((tag & ~1) != seq) continue;
+
+      float p = m_peak[ch][i & (MTR_RINGSIZE - 1)];
+      if (p > max) max = p;
+      if ((tag & 1) > 0) ovr = true;
+    }
+
+    if (max < 0.0f) return false;
+
+    *peak = (double)max;
+    *over = ovr;
+    return true;
+  } // Mtr_Collect
+
+
+private:
+  static DWORD WINAPI Mtr_SamplerProc(LPVOID p)
+  {
+    ((Mtr_Sampler*)p)->Mtr_Work();
+    return 0;
+  } // Mtr_SamplerProc
+
+  void Mtr_Work()
+  {
+    MediaTrack* tks[24];
+
+    while (!m_quit)
+    {
+      // copy the bank, again if it changed meanwhile
+      LONG seq;
+      bool copied = false;
+      do
+      {
+        seq = InterlockedCompareExchange(&m_seq, 0, 0);
+        if ((seq & 1) > 0) continue;
+
+        for (int ch = 0; ch < 24; ch++) tks[ch] = m_tks[ch];
+        copied = (InterlockedCompareExchange(&m_seq, 0, 0) == seq);
+      } while (!copied);
+
+      for (int ch = 0; ch < 24; ch++)
+      {
+        if (!tks[ch]) continue;
+
+        double peak_l = Track_GetPeakInfo(tks[ch], 0);
+        double peak_r = Track_GetPeakInfo(tks[ch], 1);
+
+        // write the sample, then publish it
+        DWORD head = (DWORD)m_head[ch];
+        m_peak[ch][head & (MTR_RINGSIZE - 1)] = (float)((peak_l + peak_r) / 2);
+        m_tag[ch][head & (MTR_RINGSIZE - 1)] = seq | (((peak_l > 1.0) || (peak_r > 1.0)) ? 1 : 0);
+        InterlockedExchange(&m_head[ch], (LONG)(head + 1));
+      }
+
+      Sleep(m_interval);
+    }
+  } // Mtr_Work
+
+
+  int m_interval; // ms
+  HANDLE m_thread;
+  volatile bool m_quit;
+
+  // bank, published by the main thread
+  volatile LONG m_seq;
+  MediaTrack* volatile m_tks[24];
+
+  // samples, written by the sampler
+  float m_peak[24][MTR_RINGSIZE];
+  volatile LONG m_tag[24][MTR_RINGSIZE]; // sequence count | over
+  volatile LONG m_head[24];
+
+  DWORD m_read[24]; // main thread
+};
+
+#endif
@@ -0,0 +1,369 @@
+/*
+** reaper_csurf
+** Tascam US-2400 support
+** MIDI output queue
+*/
+
+#ifndef _CSURF_US2400_OUTQUEUE_H_
+#define _CSURF_US2400_OUTQUEUE_H_
+
+#include "csurf_us2400_protocol.h"
+
+
+// Replaces CreateThreadedMIDIOutput: a worker thread feeds the device at most
+// 'rate' bytes per second (0 = as fast as it takes them), so a backlog builds
+// up here and not in the port's own FIFO.
+//
+// Faders, encoders, bank leds and rings / meters (0xb0) are held as one slot
+// per control: a newer value replaces a queued one and keeps its place in
+// line, so after a stall the surface gets the current state once instead of
+// every step in between. A fader's LSB is held until its MSB arrives and both
+// are sent as a pair. Buttons / leds (0xb1) and anything else stay FIFO.
+//
+// One producer (REAPER's main thread: Run() and the callbacks), one consumer
+// (the worker), no locks: a ring of entries (message or slot number) with
+// interlocked head / tail, slots swapped with InterlockedExchange.
+
+#define OUTQ_SIZE 4096 // ring entries, power of 2
+#define OUTQ_KEYS 320 // slots: 0xb0 ccs, rings / meters by cc and value nibble
+#define OUTQ_BLOCK 1024 // bytes per SendMsg
+#define OUTQ_BURST 50 // ms of rate the worker may send in one go
+#define OUTQ_IDLE 100 // ms the idle worker waits for messages before it looks again
+
+#define OUTQ_PENDING 0x10000 // slot holds a value not sent yet
+#define OUTQ_KEYED 0x40000000 // ring entry is a slot number, not a message
+
+
+class Out_Queue : public midi_Output
+{
+public:
+  Out_Queue(midi_Output* out, int rate)
+  {
+    m_output = out;
+    m_rate = rate;
+    m_quit = false;
+
+    m_head = 0;
+    m_tail = 0;
+    for (int i = 0; i < OUTQ_KEYS; i++) m_slots[i] = 0;
+    for (int i = 0; i < 25; i++) m_fdr_lsb[i] = 0;
+
+    m_queued = 0;
+    m_replaced = 0;
+    m_dropped = 0;
+    m_bytes = 0;
+    m_wakeups = 0;
+
+    // auto-reset, set by the producer after new messages
+    m_wake = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+    DWORD id;
+    m_thread = CreateThread(NULL, 0, Out_QueueProc, this, 0, &id);
+  } // Out_Queue
+
+  virtual ~Out_Queue()
+  {
+    // the worker only quits once everything is sent
+    if (m_thread)
+    {
+      m_quit = true;
+      SetEvent(m_wake);
+      WaitForSingleObject(m_thread, INFINITE);
+      CloseHandle(m_thread);
+      m_thread = 0;
+    }
+    CloseHandle(m_wake);
+
+    delete m_output;
+  } // ~Out_Queue
+
+  virtual void SendMsg(MIDI_event_t* msg, int frame_offset)
+  {
+    // split blocks (running status) into messages
+    if (!msg) return;
+
+    unsigned char* data = msg->midi_message;
+    unsigned char status = 0;
+    int i = 0;
+
+    while (i < msg->size)
+    {
+      if (data[i] & 0x80)
+      {
+        // system messages aren't used by the surface
+        status = (data[i] < 0xf0) ? data[i] : 0;
+        i++;
+
+      } else if (status == 0)
+      {
+        i++;
+
+      } else if (Out_MsgLen(status) == 2)
+      {
+        Out_Add(status, data[i], 0);
+        i++;
+
+      } else
+      {
+        if (i + 1 >= msg->size) break;
+        Out_Add(status, data[i], data[i + 1]);
+        i += 2;
+      }
+    }
+
+    // one wake-up per block
+    SetEvent(m_wake);
+  } // SendMsg
+
+  virtual void Send(unsigned char status, unsigned char d1, unsigned char d2, int)
+  {
+    // no frame offset: the worker sends as soon as the rate allows
+    Out_Add(status, d1, d2);
+    SetEvent(m_wake);
+  } // Send
+
+
+  // producer side totals
+  long m_queued, m_replaced, m_dropped;
+
+  // consumer side
+  volatile LONG m_bytes;
+  volatile LONG m_wakeups; // loops that sent nothing
+
+  bool Out_Empty()
+  {
+    return (InterlockedCompareExchange(&m_tail, 0, 0) == InterlockedCompareExchange(&m_head, 0, 0));
+  } // Out_Empty
+
+
+private:
+  void Out_Add(unsigned char status, unsigned char d1, unsigned char d2)
+  {
+    d1 = d1 & 0x7f;
+    d2 = d2 & 0x7f;
+
+    if (status == 0xb0)
+    {
+      // fader LSB: wait for the MSB
+      if ( (d1 >= Prt_Out<PRT_FDRLSB>::CC(0)) && (d1 <= Prt_Out<PRT_FDRLSB>::CC(24)) )
+      {
+        m_fdr_lsb[d1 - Prt_Out<PRT_FDRLSB>::CC(0)] = d2;
+        return;
+      }
+
+      int key = Out_Key(d1, d2);
+      LONG value = d2;
+      if (d1 <= Prt_Out<PRT_FDRMSB>::CC(24)) value = (d2 << 7) | m_fdr_lsb[d1 - Prt_Out<PRT_FDRMSB>::CC(0)];
+
+      // only a slot that wasn't pending needs a place in line
+      LONG old = InterlockedExchange(&m_slots[key], value | OUTQ_PENDING);
+      if ((old & OUTQ_PENDING) > 0)
+      {
+        m_replaced++;
+        return;
+      }
+
+      // at most one entry per slot (+1 being sent), always fits
+      Out_Push(OUTQ_KEYED | key);
+
+    } else
+    {
+      // keep room for the slots
+      if (Out_Free() <= OUTQ_KEYS + 1)
+      {
+        m_dropped++;
+        return;
+      }
+
+      Out_Push((status << 16) | (d1 << 8) | d2);
+    }
+
+    m_queued++;
+  } // Out_Add
+
+  static int Out_MsgLen(unsigned char status)
+  {
+    // program change / channel pressure
+    if ( ((status & 0xf0) == 0xc0) || ((status & 0xf0) == 0xd0) ) return 2;
+    return 3;
+  } // Out_MsgLen
+
+  static int Out_Key(unsigned char cc, unsigned char value)
+  {
+    // rings / meters: the value's high nibble selects what is set (hold 0x1X,
+    // m-key ring 0x5X ...); level 0x4X and level + over 0x6X set the same
+    // display, so they share a slot and the latest one wins
+    if ( (cc >= Prt_Out<PRT_RING>::CC(0)) && (cc <= Prt_Out<PRT_RING>::CC(23)) )
+    {
+      int set = (value >> 4) & 0x07;
+      if (set == 0x06) set = 0x04;
+      return 128 + (cc - Prt_Out<PRT_RING>::CC(0)) * 8 + set;
+    }
+
+    return cc; // faders, encoders, bank leds
+  } // Out_Key
+
+  LONG Out_Free()
+  {
+    DWORD used = (DWORD)m_head - (DWORD)InterlockedCompareExchange(&m_tail, 0, 0);
+    return OUTQ_SIZE - (LONG)used;
+  } // Out_Free
+
+  void Out_Push(LONG entry)
+  {
+    // write the entry, then publish it
+    LONG head = m_head;
+    m_ring[(DWORD)head & (OUTQ_SIZE - 1)] = entry;
+    InterlockedExchange(&m_head, (LONG)((DWORD)head + 1));
+  } // Out_Push
+
+
+  static DWORD WINAPI Out_QueueProc(LPVOID p)
+  {
+    ((Out_Queue*)p)->Out_Work();
+    return 0;
+  } // Out_QueueProc
+
+  void Out_Work()
+  {
+    struct
+    {
+      MIDI_event_t evt;
+      unsigned char more[OUTQ_BLOCK];
+    } block;
+
+    // budget in bytes * 1000 (bytes per ms at 'rate')
+    long budget = m_rate * OUTQ_BURST;
+    DWORD last = timeGetTime();
+
+    for (;;)
+    {
+      if (m_rate > 0)
+      {
+        DWORD now = timeGetTime();
+        budget += (long)(now - last) * m_rate;
+        if (budget > m_rate * OUTQ_BURST) budget = m_rate * OUTQ_BURST;
+        last = now;
+      }
+
+      int bytes = Out_Fill(block.evt.midi_message, &budget);
+
+      if (bytes > 0)
+      {
+        block.evt.frame_offset = 0;
+        block.evt.size = bytes;
+        m_output->SendMsg(&block.evt, -1);
+        m_bytes += bytes;
+
+      } else if (Out_Empty())
+      {
+        // only quit once all messages have been sent, else sleep until
+        // the producer has more (the timeout only guards a missed wake-up)
+        if (m_quit) break;
+        m_wakeups++;
+        WaitForSingleObject(m_wake, OUTQ_IDLE);
+
+      } else
+      {
+        // out of rate: wait for the budget
+        m_wakeups++;
+        Sleep(1);
+      }
+    }
+  } // Out_Work
+
+  int Out_Fill(unsigned char* out, long* budget)
+  {
+    // take entries off the ring until the block or the budget is full
+    int bytes = 0;
+    unsigned char status = 0;
+
+    while ( (bytes <= OUTQ_BLOCK - 6) && ( (m_rate == 0) || (*budget > 0) ) )
+    {
+      LONG tail = InterlockedCompareExchange(&m_tail, 0, 0);
+      if (tail == InterlockedCompareExchange(&m_head, 0, 0)) break;
+
+      // read, then free the place: a slot taken below may queue up again right away
+      LONG entry = m_ring[(DWORD)tail & (OUTQ_SIZE - 1)];
+      InterlockedExchange(&m_tail, (LONG)((DWORD)tail + 1));
+
+      unsigned char msg[2][3];
+      int msgs = 0;
+
+      if ((entry & OUTQ_KEYED) > 0)
+      {
+        int key = entry & 0xffff;
+        LONG value = InterlockedExchange(&m_slots[key], 0);
+        if ((value & OUTQ_PENDING) == 0) continue;
+
+        if (key <= Prt_Out<PRT_FDRMSB>::CC(24))
+        {
+          // fader: LSB first
+          msg[0][0] = 0xb0;
+          msg[0][1] = Prt_Out<PRT_FDRLSB>::CC(key - Prt_Out<PRT_FDRMSB>::CC(0));
+          msg[0][2] = value & 0x7f;
+          msg[1][0] = 0xb0;
+          msg[1][1] = (unsigned char)key;
+          msg[1][2] = (value >> 7) & 0x7f;
+          msgs = 2;
+
+        } else
+        {
+          msg[0][0] = 0xb0;
+          msg[0][1] = (key < 128) ? key : Prt_Out<PRT_RING>::CC((key - 128) / 8);
+          msg[0][2] = value & 0x7f;
+          msgs = 1;
+        }
+
+      } else
+      {
+        msg[0][0] = (entry >> 16) & 0xff;
+        msg[0][1] = (entry >> 8) & 0x7f;
+        msg[0][2] = entry & 0x7f;
+        msgs = 1;
+      }
+
+      // running status: repeated status bytes are left out
+      for (int m = 0; m < msgs; m++)
+      {
+        int start = bytes;
+
+        if (msg[m][0] != status)
+        {
+          status = msg[m][0];
+          out[bytes++] = status;
+        }
+        out[bytes++] = msg[m][1];
+        if (Out_MsgLen(status) == 3) out[bytes++] = msg[m][2];
+
+        *budget -= (bytes - start) * 1000;
+      }
+    }
+
+    return bytes;
+  } // Out_Fill
+
+
+  midi_Output* m_output;
+  int m_rate;
+
+  HANDLE m_thread;
+  HANDLE m_wake;
+  volatile bool m_quit;
+
+  volatile LONG m_ring[OUTQ_SIZE];
+  volatile LONG m_head, m_tail;
+
+  volatile LONG m_slots[OUTQ_KEYS];
+  unsigned char m_fdr_lsb[25]; // producer only
+};
+
+
+inline midi_Output* Out_CreateQueue(midi_Output* out, int rate)
+{
+  // returns null on null
+  if (!out) return out;
+  return new Out_Queue(out, rate);
+} // Out_CreateQueue
+
+#endif
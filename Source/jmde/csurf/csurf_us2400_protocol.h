@@ -0,0 +1,228 @@
+/*
+** reaper_csurf
+** Tascam US-2400 support
+** Native mode protocol: control map and decode table
+*/
+
+#ifndef _CSURF_US2400_PROTOCOL_H_
+#define _CSURF_US2400_PROTOCOL_H_
+
+#include <utility>
+
+
+////// CONTROLS //////
+
+// what an incoming message is (and what outgoing messages address)
+enum Prt_Handler
+{
+  PRT_NONE = 0,
+
+  // status 0xb0
+  PRT_FDRMSB,
+  PRT_FDRLSB,
+  PRT_JOG,
+  PRT_ENC,
+  PRT_BANKLED,
+  PRT_RING, // meters / pan rings in meter mode
+
+  // status 0xb1, track elements
+  PRT_TOUCH,
+  PRT_SEL,
+  PRT_SOLO,
+  PRT_MUTE,
+
+  // status 0xb1, master section
+  PRT_MASTERSEL,
+  PRT_CLRSOLO,
+  PRT_FLIP,
+  PRT_CHAN,
+  PRT_AUX,
+  PRT_METER,
+  PRT_PAN,
+  PRT_FKEY,
+  PRT_NULL,
+  PRT_SCRUB,
+  PRT_BANKDOWN,
+  PRT_BANKUP,
+  PRT_IN,
+  PRT_OUT,
+  PRT_SHIFT,
+  PRT_REW,
+  PRT_FWD,
+  PRT_STOP,
+  PRT_PLAY,
+  PRT_REC,
+
+  // status 0xb2 / 0xbe
+  PRT_MASTERTOUCH,
+  PRT_JOYSTICK,
+
+  PRT_HANDLERS
+};
+
+
+// directions
+#define PRT_I 1
+#define PRT_O 2
+#define PRT_IO 3
+
+struct Prt_Control
+{
+  unsigned char handler;
+  unsigned char status;
+  unsigned char cc_first, cc_last;
+  unsigned char cc_step; // ccs per channel, 0 = all ccs are the same channel
+  unsigned char ch_first; // channel of cc_first
+  unsigned char out_first; // output cc of ch_first (may differ from input)
+  unsigned char dir;
+};
+
+
+// The control map: input decoding (MIDIin) and output encoding
+// (MySetSurface_*) are both derived from this list.
+static constexpr Prt_Control prt_controls[] =
+{
+  // handler         status  ccs          step ch  out   dir
+  { PRT_FDRMSB,      0xb0,   0x00, 0x18,  1,   0,  0x00, PRT_IO },
+  { PRT_FDRLSB,      0xb0,   0x20, 0x38,  1,   0,  0x1f, PRT_IO },
+  { PRT_JOG,         0xb0,   0x3c, 0x3c,  0,   0,  0x3c, PRT_I },
+  { PRT_ENC,         0xb0,   0x40, 0x57,  1,   0,  0x40, PRT_IO },
+  { PRT_BANKLED,     0xb0,   0x5d, 0x5d,  0,   0,  0x5d, PRT_O },
+  { PRT_RING,        0xb0,   0x60, 0x77,  1,   0,  0x60, PRT_O },
+
+  { PRT_TOUCH,       0xb1,   0x00, 0x5c,  4,   0,  0x00, PRT_I },
+  { PRT_SEL,         0xb1,   0x01, 0x5d,  4,   0,  0x01, PRT_IO },
+  { PRT_SOLO,        0xb1,   0x02, 0x5e,  4,   0,  0x02, PRT_IO },
+  { PRT_MUTE,        0xb1,   0x03, 0x5f,  4,   0,  0x03, PRT_IO },
+
+  { PRT_MASTERSEL,   0xb1,   0x61, 0x61,  0,   24, 0x61, PRT_IO },
+  { PRT_CLRSOLO,     0xb1,   0x62, 0x62,  0,   0,  0x62, PRT_IO },
+  { PRT_FLIP,        0xb1,   0x63, 0x63,  0,   0,  0x63, PRT_IO },
+  { PRT_CHAN,        0xb1,   0x64, 0x64,  0,   0,  0x64, PRT_IO },
+  { PRT_AUX,         0xb1,   0x65, 0x6a,  1,   1,  0x65, PRT_IO }, // ch = aux 1 - 6
+  { PRT_METER,       0xb1,   0x6b, 0x6b,  0,   0,  0x6b, PRT_IO },
+  { PRT_PAN,         0xb1,   0x6c, 0x6c,  0,   0,  0x6c, PRT_IO },
+  { PRT_FKEY,        0xb1,   0x6d, 0x6d,  0,   0,  0x6d, PRT_IO },
+  { PRT_NULL,        0xb1,   0x6e, 0x6e,  0,   0,  0x6e, PRT_IO },
+  { PRT_SCRUB,       0xb1,   0x6f, 0x6f,  0,   0,  0x6f, PRT_IO },
+  { PRT_BANKDOWN,    0xb1,   0x70, 0x70,  0,   0,  0x70, PRT_IO },
+  { PRT_BANKUP,      0xb1,   0x71, 0x71,  0,   0,  0x71, PRT_IO },
+  { PRT_IN,          0xb1,   0x72, 0x72,  0,   0,  0x72, PRT_IO },
+  { PRT_OUT,         0xb1,   0x73, 0x73,  0,   0,  0x73, PRT_IO },
+  { PRT_SHIFT,       0xb1,   0x74, 0x74,  0,   0,  0x74, PRT_IO },
+  { PRT_REW,         0xb1,   0x75, 0x75,  0,   0,  0x75, PRT_IO },
+  { PRT_FWD,         0xb1,   0x76, 0x76,  0,   0,  0x76, PRT_IO },
+  { PRT_STOP,        0xb1,   0x77, 0x77,  0,   0,  0x77, PRT_IO },
+  { PRT_PLAY,        0xb1,   0x78, 0x78,  0,   0,  0x78, PRT_IO },
+  { PRT_REC,         0xb1,   0x79, 0x79,  0,   0,  0x79, PRT_IO },
+
+  { PRT_MASTERTOUCH, 0xb2,   0x00, 0x7f,  0,   24, 0x00, PRT_I },
+  { PRT_JOYSTICK,    0xbe,   0x00, 0x7f,  0,   0,  0x00, PRT_I },
+};
+
+#define PRT_CONTROLS ((int)(sizeof(prt_controls) / sizeof(prt_controls[0])))
+
+
+
+////// DECODING //////
+
+struct Prt_Decoded
+{
+  unsigned char handler;
+  unsigned char ch;
+};
+
+// decode table rows: status 0xb0, 0xb1, 0xb2, 0xbe
+#define PRT_ROWS 4
+
+static constexpr int Prt_Row(int status)
+{
+  return (status == 0xb0) ? 0 : (status == 0xb1) ? 1 : (status == 0xb2) ? 2 : (status == 0xbe) ? 3 : -1;
+}
+
+static constexpr bool Prt_Matches(const Prt_Control& c, int row, int cc)
+{
+  return ( (c.dir & PRT_I) && (Prt_Row(c.status) == row) && (cc >= c.cc_first) && (cc <= c.cc_last)
+    && ( (c.cc_step == 0) || ((cc - c.cc_first) % c.cc_step == 0) ) );
+}
+
+static constexpr Prt_Decoded Prt_Find(int row, int cc, int i)
+{
+  return (i >= PRT_CONTROLS) ? Prt_Decoded{ PRT_NONE, 0 }
+    : Prt_Matches(prt_controls[i], row, cc)
+      ? Prt_Decoded{ prt_controls[i].handler, (unsigned char)(prt_controls[i].ch_first + ((prt_controls[i].cc_step == 0) ? 0 : (cc - prt_controls[i].cc_first) / prt_controls[i].cc_step)) }
+      : Prt_Find(row, cc, i + 1);
+}
+
+
+// 4 x 128 table, generated by the compiler from prt_controls
+template <typename Seq> struct Prt_DecodeTable;
+
+template <int... idx> struct Prt_DecodeTable<std::integer_sequence<int, idx...> >
+{
+  static constexpr Prt_Decoded entries[sizeof...(idx)] = { Prt_Find(idx >> 7, idx & 0x7f, 0)... };
+};
+
+template <int... idx> constexpr Prt_Decoded Prt_DecodeTable<std::integer_sequence<int, idx...> >::entries[sizeof...(idx)];
+
+typedef Prt_DecodeTable<std::make_integer_sequence<int, PRT_ROWS * 128> > prt_decode;
+
+
+// status row by low nibble of 0xbx
+static constexpr signed char prt_status_rows[16] = { 0, 1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 3, -1 };
+
+inline const Prt_Decoded& Prt_Decode(unsigned char status, unsigned char cc)
+{
+  static const Prt_Decoded none = { PRT_NONE, 0 };
+
+  int row = ((status & 0xf0) == 0xb0) ? prt_status_rows[status & 0x0f] : -1;
+  if (row < 0) return none;
+
+  return prt_decode::entries[(row << 7) | (cc & 0x7f)];
+}
+
+
+
+////// ENCODING //////
+
+static constexpr int Prt_FindOut(int handler, int i)
+{
+  return (i >= PRT_CONTROLS) ? -1
+    : ( (prt_controls[i].handler == handler) && (prt_controls[i].dir & PRT_O) ) ? i
+    : Prt_FindOut(handler, i + 1);
+}
+
+// Prt_Out<PRT_ENC>::CC(ch) -> output cc for channel, resolved at compile time
+template <int handler> struct Prt_Out
+{
+  static_assert(Prt_FindOut(handler, 0) >= 0, "control has no output");
+
+  static const unsigned char status = prt_controls[Prt_FindOut(handler, 0)].status;
+  static const unsigned char cc = prt_controls[Prt_FindOut(handler, 0)].out_first;
+  static const unsigned char step = prt_controls[Prt_FindOut(handler, 0)].cc_step;
+  static const unsigned char ch_first = prt_controls[Prt_FindOut(handler, 0)].ch_first;
+
+  static inline unsigned char CC(int ch) { return (unsigned char)(cc + (ch - ch_first) * step); }
+};
+
+// button leds (0xb1 outputs) among the ccs row * 32 .. row * 32 + 31,
+// input-only ccs (touch ...) aren't leds
+inline unsigned long Prt_ButtonLeds(int row)
+{
+  unsigned long mask = 0;
+  for (int i = 0; i < PRT_CONTROLS; i++)
+  {
+    const Prt_Control& c = prt_controls[i];
+    if ( (c.status != 0xb1) || ((c.dir & PRT_O) == 0) ) continue;
+
+    int chs = (c.cc_step > 0) ? (c.cc_last - c.cc_first) / c.cc_step + 1 : 1;
+    for (int ch = 0; ch < chs; ch++)
+    {
+      int cc = c.out_first + ch * c.cc_step;
+      if ((cc >> 5) == row) mask = mask | (1UL << (cc & 31));
+    }
+  }
+  return mask;
+}
+
+#endif